@@ -0,0 +1,37 @@
+#include "base.hpp"
+#include "text_quality.hpp"
+#include "text_quality_parallel.hpp"
+#include "text_quality_stream.hpp"
+#include <random>
+#include <cstdio>
+#include <cstring>
+static bool same(const base::TextMetrics&a, const TextMetrics&b){
+ return a.length_chars==b.length_chars&&a.length_bytes==b.length_bytes&&a.word_count==b.word_count&&a.avg_word_len==b.avg_word_len&&a.unique_word_pct==b.unique_word_pct&&a.consecutive_dup_pct==b.consecutive_dup_pct&&a.sentences==b.sentences&&a.caps_sequences==b.caps_sequences&&a.upper_ratio==b.upper_ratio&&a.exclam_runs==b.exclam_runs&&a.quest_runs==b.quest_runs&&a.long_space_runs==b.long_space_runs&&a.junk_chars==b.junk_chars&&a.readability==b.readability;}
+static void dump(const char*tag,double a,double b){}
+int main(int argc,char**argv){
+ std::mt19937_64 rng(argc>1?atoi(argv[1]):1);
+ const char* pieces[]={"a","A","e","Y","b","Z"," ","  ","!","?",".","\t","\n","-","_","1","`","\x01","\x7f","\xd0\xb0","\xd0\x90","\xd1\x91","\xd0\x81","\xd0\xb1","\xe2\x80\x8b","\xef\xbf\xbd","\xc0","\xd0","\xe2\x80","\xf0\x9f\x98\x80","\x80","word","WORD","hello ","hello ","\xd0\xbc\xd0\xb0\xd0\xbc\xd0\xb0 "};
+ int np=sizeof(pieces)/sizeof(*pieces);
+ ThreadPool pool(3);
+ long fails=0;
+ for(int it=0;it<20000;++it){
+  std::string s; int n=rng()%(it<15000?200:20000);
+  int bias=rng()%3;
+  for(int k=0;k<n;++k){ int idx = rng()%np; if(bias==1 && rng()%2) idx=rng()%16; s+=pieces[idx]; }
+  for(const char* lang: {"ru","en","de"}){
+   auto b=base::compute_metrics(s,lang);
+   for(auto lvl:{SimdLevel::Scalar,SimdLevel::Sse2,SimdLevel::Avx2}){
+    auto m=compute_metrics(s.data(),s.size(),lang,lvl);
+    if(!same(b,m)){ if(fails++<5) printf("FAIL simd lvl=%d lang=%s len=%zu wc %ld/%ld uniq %f/%f dup %f/%f syl? read %f/%f chars %ld/%ld sent %ld/%ld ex %ld/%ld sp %ld/%ld junk %ld/%ld caps %ld/%ld\n",(int)lvl,lang,s.size(),b.word_count,m.word_count,b.unique_word_pct,m.unique_word_pct,b.consecutive_dup_pct,m.consecutive_dup_pct,b.readability,m.readability,b.length_chars,m.length_chars,b.sentences,m.sentences,b.exclam_runs,m.exclam_runs,b.long_space_runs,m.long_space_runs,b.junk_chars,m.junk_chars,b.caps_sequences,m.caps_sequences);}
+   }
+   ParallelMetricsOptions po; po.min_chunk_bytes=64;
+   auto pm=compute_metrics_parallel(s.data(),s.size(),lang,pool,po);
+   if(!same(b,pm)){ if(fails++<10) printf("FAIL parallel lang=%s len=%zu\n",lang,s.size());}
+   TextMetricsAccumulator acc(lang);
+   size_t pos=0; while(pos<s.size()){ size_t c=rng()%(rng()%2?5:100); c=std::min(c,s.size()-pos); acc.feed(s.data()+pos,c); pos+=c;}
+   auto sm=acc.finish();
+   if(!same(b,sm)){ if(fails++<15) printf("FAIL stream lang=%s len=%zu wc %ld/%ld chars %ld/%ld\n",lang,s.size(),b.word_count,sm.word_count,b.length_chars,sm.length_chars);}
+  }
+ }
+ printf("fails=%ld\n",fails);
+}
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Сравнение двух TSV из text_quality_bench --tsv_out=...:
+#   ./compare.sh old.tsv new.tsv
+# Для каждого бенчмарка: время old/new, ускорение и изменение числа аллокаций.
+set -e
+[ $# -eq 2 ] || { echo "usage: $0 old.tsv new.tsv" >&2; exit 1; }
+
+awk -F'\t' '
+  /^#/ { next }
+  FNR == NR { ns[$1] = $2; allocs[$1] = $5; next }
+  ($1 in ns) {
+    speedup = ($2 > 0) ? ns[$1] / $2 : 0
+    printf "%-48s %12.0f %12.0f %7.2fx %8.4g -> %-8.4g\n", $1, ns[$1], $2, speedup, allocs[$1], $5
+  }
+' "$1" "$2"
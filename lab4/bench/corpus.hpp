@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Детерминированный генератор текстов для бенчмарков: одинаковые (kind, bytes, seed)
+// дают побайтно одинаковый корпус на любой машине.
+enum class CorpusKind
+{
+    En,
+    Ru,
+    Mixed,
+    Junk
+};
+
+inline const char *corpus_kind_name(CorpusKind kind)
+{
+    switch (kind)
+    {
+    case CorpusKind::En:
+        return "en";
+    case CorpusKind::Ru:
+        return "ru";
+    case CorpusKind::Mixed:
+        return "mixed";
+    default:
+        return "junk";
+    }
+}
+
+inline const char *corpus_kind_lang(CorpusKind kind)
+{
+    return (kind == CorpusKind::En) ? "en" : "ru";
+}
+
+// splitmix64: свой ГПСЧ, чтобы не зависеть от реализации <random>
+struct SplitMix64
+{
+    uint64_t state;
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+};
+
+inline std::string make_corpus(CorpusKind kind, size_t bytes, uint64_t seed = 42)
+{
+    static const char *en[] = {
+        "the", "quality", "of", "text", "service", "request", "result", "worker", "gateway", "message",
+        "is", "and", "a", "to", "in", "for", "with", "readability", "score", "metrics",
+        "partition", "consumer", "producer", "broker", "latency", "throughput", "simple", "heuristic", "word", "sentence"};
+    static const char *ru[] = {
+        "текст", "качество", "сервис", "запрос", "результат", "обработка", "сообщение", "и", "в", "на",
+        "не", "что", "это", "для", "метрика", "читабельность", "оценка", "брокер", "раздел", "задержка",
+        "пропускная", "способность", "простой", "слово", "предложение", "вычисление", "поток", "очередь", "кэш", "ответ"};
+    static const char *junk[] = {"\x01", "\x7F", "\xE2\x80\x8B", "\xE2\x80\x8D", "~", "^", "`", "\xFF", "\xC3", "!!!!", "???", "     "};
+
+    SplitMix64 rng{seed ^ (static_cast<uint64_t>(kind) << 56)};
+    std::string out;
+    out.reserve(bytes + 64);
+
+    size_t words_in_sentence = 0;
+    bool sentence_start = true;
+    while (out.size() < bytes)
+    {
+        const bool use_ru = (kind == CorpusKind::Ru || kind == CorpusKind::Junk) ||
+                            (kind == CorpusKind::Mixed && rng.below(2) == 0);
+        std::string w = use_ru ? ru[rng.below(30)] : en[rng.below(30)];
+
+        if (!use_ru)
+        {
+            if (rng.below(50) == 0)
+                for (auto &c : w)
+                    c = static_cast<char>(c - 32); // CAPS
+            else if (sentence_start)
+                w[0] = static_cast<char>(w[0] - 32);
+        }
+        out += w;
+        sentence_start = false;
+
+        if (kind == CorpusKind::Junk && rng.below(4) == 0)
+            out += junk[rng.below(12)];
+
+        if (++words_in_sentence >= 4 + rng.below(12))
+        {
+            static const char *ends[] = {". ", ". ", ". ", "! ", "? ", "!!! ", "...\n"};
+            out += ends[rng.below(7)];
+            words_in_sentence = 0;
+            sentence_start = true;
+        }
+        else
+        {
+            out += (rng.below(40) == 0) ? "   " : (rng.below(12) == 0 ? ", " : " ");
+        }
+    }
+
+    // обрезаем по границе кодпоинта
+    size_t n = bytes;
+    while (n > 0 && n < out.size() && (static_cast<unsigned char>(out[n]) & 0xC0) == 0x80)
+        --n;
+    out.resize(n);
+    return out;
+}
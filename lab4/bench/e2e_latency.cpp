@@ -0,0 +1,182 @@
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "corpus.hpp"
+#include "http_client.hpp"
+
+// Сквозная задержка POST /check -> GET /result/{id}?wait_ms=... на работающем gateway.
+// Закрытый цикл: --concurrency клиентов, каждый отправляет следующий запрос после
+// получения результата предыдущего. Запускается против двух gateway -- с Kafka и
+// PIPELINE_MODE=inprocess (см. README) -- и сравниваются перцентили.
+//
+//   e2e_latency --url=localhost:8080 --requests=2000 --concurrency=8 --bytes=1024 --lang=ru
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string url = "localhost:8080";
+    size_t requests = 1000;
+    size_t concurrency = 4;
+    size_t bytes = 1024;
+    std::string lang = "ru";
+    int wait_ms = 10000;
+    size_t warmup = 50; // на клиента, в статистику не идут
+};
+
+static bool parse_flag(const char *arg, const char *name, std::string &out)
+{
+    const size_t n = std::strlen(name);
+    if (std::strncmp(arg, name, n) != 0 || arg[n] != '=')
+        return false;
+    out = arg + n + 1;
+    return true;
+}
+
+static bool parse_options(int argc, char **argv, Options &o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string v;
+        if (parse_flag(argv[i], "--url", v))
+            o.url = v;
+        else if (parse_flag(argv[i], "--requests", v))
+            o.requests = std::strtoull(v.c_str(), nullptr, 10);
+        else if (parse_flag(argv[i], "--concurrency", v))
+            o.concurrency = std::max<size_t>(1, std::strtoull(v.c_str(), nullptr, 10));
+        else if (parse_flag(argv[i], "--bytes", v))
+            o.bytes = std::strtoull(v.c_str(), nullptr, 10);
+        else if (parse_flag(argv[i], "--lang", v))
+            o.lang = v;
+        else if (parse_flag(argv[i], "--wait_ms", v))
+            o.wait_ms = std::atoi(v.c_str());
+        else if (parse_flag(argv[i], "--warmup", v))
+            o.warmup = std::strtoull(v.c_str(), nullptr, 10);
+        else
+        {
+            std::cerr << "unknown flag: " << argv[i] << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+static int64_t us_since(Clock::time_point t0)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+}
+
+static void print_percentiles(const char *name, std::vector<int64_t> &us)
+{
+    if (us.empty())
+    {
+        std::printf("%-8s no samples\n", name);
+        return;
+    }
+    std::sort(us.begin(), us.end());
+    auto at = [&](double q)
+    { return double(us[std::min(us.size() - 1, size_t(q * double(us.size())))]) / 1000.0; };
+    std::printf("%-8s n=%zu p50=%.3fms p90=%.3fms p99=%.3fms p99.9=%.3fms max=%.3fms\n",
+                name, us.size(), at(0.50), at(0.90), at(0.99), at(0.999), double(us.back()) / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts))
+        return 2;
+    std::string host;
+    uint16_t port = 0;
+    if (!HttpClient::parse_address(opts.url, host, port))
+    {
+        std::cerr << "bad --url: " << opts.url << " (expected host:port)\n";
+        return 2;
+    }
+
+    const CorpusKind kind = opts.lang == "en" ? CorpusKind::En : CorpusKind::Ru;
+    const std::string body = json{{"text", make_corpus(kind, opts.bytes)}, {"language", opts.lang}}.dump();
+
+    std::vector<std::vector<int64_t>> accept_us(opts.concurrency), e2e_us(opts.concurrency);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed{0}, timed_out{0};
+
+    auto client_loop = [&](size_t c)
+    {
+        HttpClient client(host, port);
+        HttpClient::Response resp;
+        for (size_t k = 0;; ++k)
+        {
+            const bool warm = k < opts.warmup;
+            if (!warm && next.fetch_add(1, std::memory_order_relaxed) >= opts.requests)
+                break;
+
+            const Clock::time_point t0 = Clock::now();
+            if (!client.post("/check", body, resp) || resp.status != 200)
+            {
+                failed++;
+                continue;
+            }
+            const int64_t accepted = us_since(t0);
+            std::string id;
+            try
+            {
+                id = json::parse(resp.body).at("request_id").get<std::string>();
+            }
+            catch (const std::exception &)
+            {
+                failed++;
+                continue;
+            }
+            if (!client.get("/result/" + id + "?wait_ms=" + std::to_string(opts.wait_ms), resp) ||
+                resp.status != 200)
+            {
+                failed++;
+                continue;
+            }
+            if (resp.body.find("\"processing\"") != std::string::npos)
+            {
+                timed_out++;
+                continue;
+            }
+            if (!warm)
+            {
+                accept_us[c].push_back(accepted);
+                e2e_us[c].push_back(us_since(t0));
+            }
+        }
+    };
+
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < opts.concurrency; ++c)
+        clients.emplace_back(client_loop, c);
+    for (auto &t : clients)
+        t.join();
+    const double wall_s = double(us_since(start)) / 1e6;
+
+    std::vector<int64_t> accept_all, e2e_all;
+    for (size_t c = 0; c < opts.concurrency; ++c)
+    {
+        accept_all.insert(accept_all.end(), accept_us[c].begin(), accept_us[c].end());
+        e2e_all.insert(e2e_all.end(), e2e_us[c].begin(), e2e_us[c].end());
+    }
+
+    std::printf("url=%s requests=%zu concurrency=%zu bytes=%zu lang=%s\n",
+                opts.url.c_str(), opts.requests, opts.concurrency, opts.bytes, opts.lang.c_str());
+    print_percentiles("accept", accept_all);
+    print_percentiles("e2e", e2e_all);
+    std::printf("throughput=%.1f req/s failed=%zu timed_out=%zu\n",
+                double(e2e_all.size()) / wall_s, failed.load(), timed_out.load());
+    return failed.load() > 0 ? 1 : 0;
+}
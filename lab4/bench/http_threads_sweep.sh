@@ -0,0 +1,55 @@
+#!/bin/sh
+# req/s gateway в зависимости от числа HTTP-потоков:
+#   ./http_threads_sweep.sh build/gateway/gateway build/loadgen/loadgen [потоки...]
+# Для каждого числа потоков gateway запускается в режиме inprocess (без Kafka),
+# loadgen подаёт каждую частоту из RATES; по строке таблицы на пару потоки/частота.
+# Предел хоста -- наибольшая частота, на которой completed/s ещё равна поданной,
+# а p99 остаётся в допуске. Переменные: RATES, DURATION, MIX, PORT, PIN (HTTP_PIN_THREADS).
+set -e
+[ $# -ge 2 ] || { echo "usage: $0 gateway loadgen [threads...]" >&2; exit 1; }
+GW=$1
+LG=$2
+shift 2
+THREADS=${*:-"1 2 4 8 16"}
+RATES=${RATES:-"1000 2000 4000 8000 16000"}
+DURATION=${DURATION:-10}
+MIX=${MIX:-256:1}
+PORT=${PORT:-18080}
+PIN=${PIN:-0}
+
+printf "threads\trate\tcompleted_per_s\taccept_p99_ms\tcomplete_p99_ms\trejected\n"
+for t in $THREADS; do
+  HTTP_PORT=$PORT HTTP_THREADS=$t HTTP_PIN_THREADS=$PIN PIPELINE_MODE=inprocess LOG_LEVEL=warn \
+    "$GW" >/dev/null 2>&1 &
+  gw_pid=$!
+  i=0
+  until curl -sf "http://localhost:$PORT/health" >/dev/null 2>&1; do
+    i=$((i + 1))
+    [ $i -lt 100 ] || { echo "gateway did not start" >&2; kill $gw_pid; exit 1; }
+    sleep 0.1
+  done
+
+  for r in $RATES; do
+    "$LG" --url=localhost:$PORT --rate=$r --duration=$DURATION --mix=$MIX 2>/dev/null |
+      awk -v t=$t -v r=$r '
+        # "p99=   1.234": значение выровнено пробелами и может оказаться в следующем поле
+        function p99(   i, v) {
+          for (i = 2; i <= NF; i++)
+            if ($i ~ /^p99=/) { v = substr($i, 5); return v != "" ? v : $(i + 1) }
+        }
+        $1 == "accept" { acc = p99() }
+        $1 == "complete" { cmp = p99() }
+        /^sent=/ {
+          for (i = 1; i <= NF; i++) {
+            split($i, kv, "=")
+            if (kv[1] == "completed_per_s") tput = kv[2]
+            if (kv[1] == "rejected") rej = kv[2]
+          }
+        }
+        END { printf "%s\t%s\t%s\t%s\t%s\t%s\n", t, r, tput, acc, cmp, rej }
+      ' || true
+  done
+
+  kill $gw_pid
+  wait $gw_pid 2>/dev/null || true
+done
@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "request_id.hpp"
+
+// Генерация request_id: прежний gen_request_id (mt19937_64 + две std::string)
+// против RequestId (splitmix64 на поток, 32 hex в буфере на стеке), а также
+// поиск в unordered_map по строковому и по 16-байтовому ключу.
+
+static std::string legacy_request_id()
+{
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+    std::uniform_int_distribution<uint64_t> dist(0, std::numeric_limits<uint64_t>::max());
+
+    auto to_hex16 = [](uint64_t x)
+    {
+        const char *hex = "0123456789abcdef";
+        std::string s(16, '0');
+        for (int i = 15; i >= 0; --i)
+        {
+            s[i] = hex[x & 0xF];
+            x >>= 4;
+        }
+        return s;
+    };
+    return to_hex16(dist(rng)) + to_hex16(dist(rng));
+}
+
+static void bm_legacy(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        std::string id = legacy_request_id();
+        benchmark::DoNotOptimize(id.data());
+    }
+}
+
+static void bm_generate(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        RequestId id = RequestId::generate();
+        benchmark::DoNotOptimize(id);
+    }
+}
+
+static void bm_generate_hex(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        RequestId::Hex hex = RequestId::generate().hex();
+        benchmark::DoNotOptimize(hex.data);
+    }
+}
+
+static void bm_parse(benchmark::State &state)
+{
+    const RequestId::Hex hex = RequestId::generate().hex();
+    RequestId id;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(RequestId::parse(hex.view(), id));
+        benchmark::DoNotOptimize(id);
+    }
+}
+
+static const size_t kLookupKeys = 1 << 16;
+
+static void bm_lookup_string(benchmark::State &state)
+{
+    std::unordered_map<std::string, int> map;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kLookupKeys; ++i)
+    {
+        keys.push_back(RequestId::generate().str());
+        map.emplace(keys.back(), static_cast<int>(i));
+    }
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        auto it = map.find(keys[i++ & (kLookupKeys - 1)]);
+        benchmark::DoNotOptimize(it);
+    }
+}
+
+static void bm_lookup_binary(benchmark::State &state)
+{
+    std::unordered_map<RequestId, int, RequestIdHash> map;
+    std::vector<RequestId> keys;
+    for (size_t i = 0; i < kLookupKeys; ++i)
+    {
+        keys.push_back(RequestId::generate());
+        map.emplace(keys.back(), static_cast<int>(i));
+    }
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        auto it = map.find(keys[i++ & (kLookupKeys - 1)]);
+        benchmark::DoNotOptimize(it);
+    }
+}
+
+BENCHMARK(bm_legacy)->ThreadRange(1, 8);
+BENCHMARK(bm_generate)->ThreadRange(1, 8);
+BENCHMARK(bm_generate_hex)->ThreadRange(1, 8);
+BENCHMARK(bm_parse);
+BENCHMARK(bm_lookup_string);
+BENCHMARK(bm_lookup_binary);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,182 @@
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "request_id.hpp"
+#include "result_cache.hpp"
+
+// Кэш результатов gateway: прежняя схема (unordered_map<string, shared_ptr<string>>
+// и FIFO строковых id) против ResultCache (16-байтовые ключи, открытая адресация,
+// тела в кольце). Заполнение N результатов, поиск с чтением тела и память на запись
+// (bytes_per_entry): для прежней схемы -- прирост кучи по mallinfo2, для ResultCache --
+// memory_bytes().
+
+static const size_t kBodyBytes = 320; // типичный JSON результата с метриками
+static const size_t kShards = 64;
+
+struct LegacyEntry
+{
+    std::shared_ptr<const std::string> body;
+    int64_t inserted_ms;
+};
+
+struct LegacyExpiry
+{
+    std::string id;
+    int64_t inserted_ms;
+};
+
+// один шард прежнего ResultCache
+struct LegacyCache
+{
+    mutable std::shared_mutex mtx;
+    std::unordered_map<std::string, LegacyEntry> map;
+    std::deque<LegacyExpiry> expiry;
+
+    void put(const std::string &id, const std::string &body, int64_t ts)
+    {
+        map.insert_or_assign(id, LegacyEntry{std::make_shared<const std::string>(body), ts});
+        expiry.push_back(LegacyExpiry{id, ts});
+    }
+
+    std::shared_ptr<const std::string> get(const std::string &id) const
+    {
+        std::shared_lock<std::shared_mutex> lk(mtx);
+        auto it = map.find(id);
+        return it == map.end() ? nullptr : it->second.body;
+    }
+};
+
+static size_t heap_bytes()
+{
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+static std::vector<std::string> make_ids(size_t n)
+{
+    std::vector<std::string> ids;
+    ids.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        ids.push_back(RequestId::generate().str());
+    return ids;
+}
+
+// Порядок поиска -- случайный: в порядке вставки прежняя схема выигрывала бы
+// от того, что malloc выдал соседние тела подряд.
+static std::vector<std::string> shuffled(std::vector<std::string> ids)
+{
+    std::shuffle(ids.begin(), ids.end(), std::mt19937_64(42));
+    return ids;
+}
+
+static void bm_fill_legacy(benchmark::State &state)
+{
+    const size_t n = static_cast<size_t>(state.range(0));
+    const std::vector<std::string> ids = make_ids(n);
+    const std::string body(kBodyBytes, 'x');
+    double bytes_per_entry = 0;
+    for (auto _ : state)
+    {
+        const size_t before = heap_bytes();
+        auto cache = std::make_unique<LegacyCache>();
+        for (size_t i = 0; i < n; ++i)
+            cache->put(ids[i], body, static_cast<int64_t>(i));
+        bytes_per_entry = double(heap_bytes() - before) / double(n);
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.counters["bytes_per_entry"] = bytes_per_entry;
+    state.counters["puts"] = benchmark::Counter(double(n), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void bm_fill_flat(benchmark::State &state)
+{
+    const size_t n = static_cast<size_t>(state.range(0));
+    const std::vector<std::string> ids = make_ids(n);
+    const std::string body(kBodyBytes, 'x');
+    double bytes_per_entry = 0;
+    for (auto _ : state)
+    {
+        auto cache = std::make_unique<ResultCache>(kShards, size_t{2} << 30);
+        for (size_t i = 0; i < n; ++i)
+            cache->put(ids[i], body, static_cast<int64_t>(i));
+        bytes_per_entry = double(cache->memory_bytes()) / double(cache->size());
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.counters["bytes_per_entry"] = bytes_per_entry;
+    state.counters["puts"] = benchmark::Counter(double(n), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void bm_get_legacy(benchmark::State &state)
+{
+    const size_t n = static_cast<size_t>(state.range(0));
+    const std::vector<std::string> ids = make_ids(n);
+    LegacyCache cache;
+    for (size_t i = 0; i < n; ++i)
+        cache.put(ids[i], std::string(kBodyBytes, 'x'), static_cast<int64_t>(i));
+    std::string out;
+    out.reserve(kBodyBytes);
+    const std::vector<std::string> order = shuffled(ids);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        std::shared_ptr<const std::string> body = cache.get(order[i++ % n]);
+        out.assign(*body); // отправка ответа читает тело
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void bm_get_flat(benchmark::State &state)
+{
+    const size_t n = static_cast<size_t>(state.range(0));
+    const std::vector<std::string> ids = make_ids(n);
+    ResultCache cache(kShards, size_t{2} << 30);
+    for (size_t i = 0; i < n; ++i)
+        cache.put(ids[i], std::string(kBodyBytes, 'x'), static_cast<int64_t>(i));
+    std::string out;
+    out.reserve(kBodyBytes);
+    const std::vector<std::string> order = shuffled(ids);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cache.copy_to(order[i++ % n], out)); // как GET /result
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+// Установившийся режим под бюджетом: каждая вставка вытесняет старейшую запись.
+static void bm_put_budget(benchmark::State &state)
+{
+    const std::vector<std::string> ids = make_ids(1 << 20);
+    const std::string body(kBodyBytes, 'x');
+    ResultCache cache(kShards, size_t{64} << 20);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        cache.put(ids[i & ((1 << 20) - 1)], body, static_cast<int64_t>(i));
+        ++i;
+    }
+    state.counters["entries"] = double(cache.size());
+    state.counters["bytes_per_entry"] = double(cache.memory_bytes()) / double(cache.size());
+}
+
+BENCHMARK(bm_fill_legacy)->Arg(1 << 20)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(bm_fill_flat)->Arg(1 << 20)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(bm_get_legacy)->Arg(1 << 14)->Arg(1 << 20);
+BENCHMARK(bm_get_flat)->Arg(1 << 14)->Arg(1 << 20);
+BENCHMARK(bm_put_budget);
+
+BENCHMARK_MAIN();
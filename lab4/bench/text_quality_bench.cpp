@@ -0,0 +1,314 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+#include "text_quality.hpp"
+#include "text_quality_parallel.hpp"
+#include "text_quality_stream.hpp"
+
+// --- подсчёт аллокаций: глобальные operator new/delete этого бинарника ---
+// Заменён весь набор (обычные, массивы, nothrow, выровненные, sized delete), и все
+// формы сводятся к одной паре count_alloc/release: так каждой аллокации соответствует
+// освобождение той же функцией, без смешения malloc/free с библиотечным new.
+static std::atomic<int64_t> g_allocs{0};
+
+static void *count_alloc(size_t n, size_t align) noexcept
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (n == 0)
+        n = 1;
+    if (align <= alignof(std::max_align_t))
+        return std::malloc(n);
+    return std::aligned_alloc(align, (n + align - 1) / align * align);
+}
+
+static void release(void *p) noexcept { std::free(p); }
+
+static void *count_alloc_or_throw(size_t n, size_t align)
+{
+    if (void *p = count_alloc(n, align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t n) { return count_alloc_or_throw(n, 0); }
+void *operator new[](size_t n) { return count_alloc_or_throw(n, 0); }
+void *operator new(size_t n, std::align_val_t a) { return count_alloc_or_throw(n, static_cast<size_t>(a)); }
+void *operator new[](size_t n, std::align_val_t a) { return count_alloc_or_throw(n, static_cast<size_t>(a)); }
+void *operator new(size_t n, const std::nothrow_t &) noexcept { return count_alloc(n, 0); }
+void *operator new[](size_t n, const std::nothrow_t &) noexcept { return count_alloc(n, 0); }
+void *operator new(size_t n, std::align_val_t a, const std::nothrow_t &) noexcept { return count_alloc(n, static_cast<size_t>(a)); }
+void *operator new[](size_t n, std::align_val_t a, const std::nothrow_t &) noexcept { return count_alloc(n, static_cast<size_t>(a)); }
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, size_t) noexcept { release(p); }
+void operator delete[](void *p, size_t) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { release(p); }
+
+static const CorpusKind kKinds[] = {CorpusKind::En, CorpusKind::Ru, CorpusKind::Mixed, CorpusKind::Junk};
+static const size_t kSizes[] = {64, 1 << 10, 16 << 10, 256 << 10, 4 << 20, 16 << 20};
+
+// Корпуса генерируются один раз и переиспользуются всеми бенчмарками.
+static const std::string &corpus(CorpusKind kind, size_t bytes)
+{
+    static std::map<std::pair<int, size_t>, std::string> cache;
+    auto key = std::make_pair(static_cast<int>(kind), bytes);
+    auto it = cache.find(key);
+    if (it == cache.end())
+        it = cache.emplace(key, make_corpus(kind, bytes)).first;
+    return it->second;
+}
+
+static void set_common_counters(benchmark::State &state, int64_t bytes, int64_t cps, int64_t allocs)
+{
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.counters["cps"] = benchmark::Counter(double(cps) * double(state.iterations()),
+                                               benchmark::Counter::kIsRate);
+    state.counters["allocs"] = benchmark::Counter(double(allocs), benchmark::Counter::kAvgIterations);
+}
+
+static void bm_compute_metrics(benchmark::State &state, CorpusKind kind, size_t size, SimdLevel level)
+{
+    const std::string &text = corpus(kind, size);
+    const std::string lang = corpus_kind_lang(kind);
+    compute_metrics(text.data(), text.size(), lang, level); // прогрев thread_local таблицы
+
+    int64_t cps = 0;
+    int64_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+    for (auto _ : state)
+    {
+        TextMetrics m = compute_metrics(text.data(), text.size(), lang, level);
+        benchmark::DoNotOptimize(m);
+        cps = m.length_chars;
+    }
+    set_common_counters(state, static_cast<int64_t>(text.size()), cps,
+                        g_allocs.load(std::memory_order_relaxed) - allocs_before);
+}
+
+// Масштабирование параллельного режима: threads -- всего потоков (пул + вызывающий).
+static void bm_compute_metrics_parallel(benchmark::State &state, CorpusKind kind, size_t size, size_t threads)
+{
+    const std::string &text = corpus(kind, size);
+    const std::string lang = corpus_kind_lang(kind);
+    ThreadPool pool(threads - 1);
+
+    int64_t cps = 0;
+    for (auto _ : state)
+    {
+        TextMetrics m = compute_metrics_parallel(text.data(), text.size(), lang, pool);
+        benchmark::DoNotOptimize(m);
+        cps = m.length_chars;
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.counters["cps"] = benchmark::Counter(double(cps) * double(state.iterations()),
+                                               benchmark::Counter::kIsRate);
+}
+
+// Потоковый режим: тот же текст кусками по chunk байт (накладные расходы на стыках).
+static void bm_accumulator(benchmark::State &state, CorpusKind kind, size_t size, size_t chunk)
+{
+    const std::string &text = corpus(kind, size);
+    const std::string lang = corpus_kind_lang(kind);
+
+    int64_t cps = 0;
+    int64_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+    for (auto _ : state)
+    {
+        TextMetricsAccumulator acc(lang);
+        for (size_t pos = 0; pos < text.size(); pos += chunk)
+            acc.feed(text.data() + pos, std::min(chunk, text.size() - pos));
+        TextMetrics m = acc.finish();
+        benchmark::DoNotOptimize(m);
+        cps = m.length_chars;
+    }
+    set_common_counters(state, static_cast<int64_t>(text.size()), cps,
+                        g_allocs.load(std::memory_order_relaxed) - allocs_before);
+}
+
+static void bm_compute_score(benchmark::State &state, CorpusKind kind)
+{
+    const std::string lang = corpus_kind_lang(kind);
+    const TextMetrics m = compute_metrics(corpus(kind, 16 << 10), lang);
+
+    std::vector<std::string> errors;
+    errors.reserve(4);
+    int64_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+    for (auto _ : state)
+    {
+        errors.clear();
+        int score = compute_score(m, lang, errors);
+        benchmark::DoNotOptimize(score);
+    }
+    state.counters["allocs"] = benchmark::Counter(double(g_allocs.load(std::memory_order_relaxed) - allocs_before),
+                                                  benchmark::Counter::kAvgIterations);
+}
+
+static void bm_count_vowel_groups(benchmark::State &state, CorpusKind kind)
+{
+    // слова корпуса в виде u32string, как их принимает count_vowel_groups
+    const std::string &text = corpus(kind, 16 << 10);
+    const std::string lang = corpus_kind_lang(kind);
+    std::vector<std::u32string> words;
+    std::u32string cur;
+    size_t i = 0;
+    uint32_t cp = 0;
+    int64_t cps = 0;
+    while (utf8_next(text, i, cp))
+    {
+        if (is_word_char(cp))
+        {
+            cur.push_back(cp);
+            cps++;
+        }
+        else if (!cur.empty())
+        {
+            words.push_back(cur);
+            cur.clear();
+        }
+    }
+
+    int64_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+    for (auto _ : state)
+    {
+        int64_t groups = 0;
+        for (const auto &w : words)
+            groups += count_vowel_groups(w, lang);
+        benchmark::DoNotOptimize(groups);
+    }
+    set_common_counters(state, 0, cps, g_allocs.load(std::memory_order_relaxed) - allocs_before);
+    state.counters["words"] = double(words.size());
+}
+
+static void register_benchmarks()
+{
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+    if (classify32_for(SimdLevel::Sse2))
+        levels.push_back(SimdLevel::Sse2);
+    if (active_simd_level() == SimdLevel::Avx2)
+        levels.push_back(SimdLevel::Avx2);
+
+    for (SimdLevel level : levels)
+        for (CorpusKind kind : kKinds)
+            for (size_t size : kSizes)
+            {
+                std::string name = std::string("compute_metrics/") + simd_level_name(level) + "/" +
+                                   corpus_kind_name(kind) + "/" + std::to_string(size);
+                benchmark::RegisterBenchmark(name.c_str(), bm_compute_metrics, kind, size, level);
+            }
+
+    for (CorpusKind kind : kKinds)
+        for (size_t threads : {1, 2, 4, 8})
+        {
+            std::string name = std::string("compute_metrics_parallel/") + std::to_string(threads) + "/" +
+                               corpus_kind_name(kind) + "/" + std::to_string(16 << 20);
+            benchmark::RegisterBenchmark(name.c_str(), bm_compute_metrics_parallel, kind, size_t(16) << 20, threads)
+                ->UseRealTime();
+        }
+
+    for (CorpusKind kind : kKinds)
+        for (size_t chunk : {size_t(4) << 10, size_t(64) << 10})
+        {
+            std::string name = std::string("accumulator/") + std::to_string(chunk) + "/" +
+                               corpus_kind_name(kind) + "/" + std::to_string(4 << 20);
+            benchmark::RegisterBenchmark(name.c_str(), bm_accumulator, kind, size_t(4) << 20, chunk);
+        }
+
+    for (CorpusKind kind : kKinds)
+    {
+        benchmark::RegisterBenchmark((std::string("compute_score/") + corpus_kind_name(kind)).c_str(),
+                                     bm_compute_score, kind);
+        benchmark::RegisterBenchmark((std::string("count_vowel_groups/") + corpus_kind_name(kind)).c_str(),
+                                     bm_count_vowel_groups, kind);
+    }
+}
+
+// Консольный вывод плюс стабильная TSV-таблица (без дат и параметров машины),
+// которую удобно сравнивать между коммитами: bench/compare.sh old.tsv new.tsv
+class TsvCollector : public benchmark::ConsoleReporter
+{
+public:
+    void ReportRuns(const std::vector<Run> &runs) override
+    {
+        ConsoleReporter::ReportRuns(runs);
+        for (const auto &run : runs)
+        {
+            if (run.error_occurred || run.run_type != Run::RT_Iteration)
+                continue;
+            auto counter = [&](const char *name)
+            {
+                auto it = run.counters.find(name);
+                return it == run.counters.end() ? 0.0 : it->second.value;
+            };
+            char line[512];
+            std::snprintf(line, sizeof(line), "%s\t%.0f\t%.4g\t%.4g\t%.4g\t%.1f\n",
+                          run.benchmark_name().c_str(),
+                          run.real_accumulated_time * 1e9 / double(run.iterations),
+                          counter("bytes_per_second"), counter("cps"), counter("allocs"), counter("words"));
+            rows_ += line;
+        }
+    }
+
+    bool write(const std::string &path) const
+    {
+        std::ofstream out(path);
+        out << "# name\tns_per_call\tbytes_per_s\tcodepoints_per_s\tallocs_per_call\twords\n"
+            << rows_;
+        return static_cast<bool>(out);
+    }
+
+private:
+    std::string rows_;
+};
+
+int main(int argc, char **argv)
+{
+    // --tsv_out=<file> -- свой флаг, убираем его до разбора флагов benchmark
+    std::string tsv_out;
+    std::vector<char *> args;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--tsv_out=", 10) == 0)
+            tsv_out = argv[i] + 10;
+        else
+            args.push_back(argv[i]);
+    }
+    int n = static_cast<int>(args.size());
+
+    register_benchmarks();
+    benchmark::Initialize(&n, args.data());
+    if (benchmark::ReportUnrecognizedArguments(n, args.data()))
+        return 1;
+
+    std::cerr << "simd level: " << simd_level_name(active_simd_level()) << "\n";
+
+    TsvCollector reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    if (!tsv_out.empty() && !reporter.write(tsv_out))
+    {
+        std::cerr << "failed to write " << tsv_out << "\n";
+        return 1;
+    }
+    return 0;
+}
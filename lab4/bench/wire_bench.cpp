@@ -0,0 +1,238 @@
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+#include "json_scan.hpp"
+#include "wire.hpp"
+
+// JSON (nlohmann, как было в gateway/worker) против бинарного формата wire.hpp:
+// время кодирования/разбора сообщения и его размер (счётчик wire_bytes).
+
+using json = nlohmann::json;
+
+static const char *kRequestId = "3f2b8c1d9e7a46b0a1c2d3e4f5061728";
+static const int64_t kTimestamp = 1700000000000;
+
+static const size_t kSizes[] = {1 << 10, 16 << 10, 256 << 10};
+
+static std::string json_request(const std::string &text)
+{
+    return json{{"request_id", kRequestId}, {"timestamp", kTimestamp}, {"text", text}, {"language", "ru"}}.dump();
+}
+
+static std::string binary_request(const std::string &text)
+{
+    std::string out;
+    wire::encode_request(wire::Request{kRequestId, kTimestamp, "ru", text}, out);
+    return out;
+}
+
+static void bm_request_json_dump(benchmark::State &state, size_t size)
+{
+    const std::string text = make_corpus(CorpusKind::Ru, size);
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        std::string payload = json_request(text);
+        bytes = payload.size();
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(text.size()));
+    state.counters["wire_bytes"] = double(bytes);
+}
+
+static void bm_request_json_parse(benchmark::State &state, size_t size)
+{
+    const std::string payload = json_request(make_corpus(CorpusKind::Ru, size));
+    for (auto _ : state)
+    {
+        auto j = json::parse(payload);
+        benchmark::DoNotOptimize(j["text"].get_ref<const std::string &>().data());
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(size));
+    state.counters["wire_bytes"] = double(payload.size());
+}
+
+static void bm_request_binary_encode(benchmark::State &state, size_t size)
+{
+    const std::string text = make_corpus(CorpusKind::Ru, size);
+    std::string payload;
+    for (auto _ : state)
+    {
+        wire::encode_request(wire::Request{kRequestId, kTimestamp, "ru", text}, payload);
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(text.size()));
+    state.counters["wire_bytes"] = double(payload.size());
+}
+
+static void bm_request_binary_decode(benchmark::State &state, size_t size)
+{
+    const std::string payload = binary_request(make_corpus(CorpusKind::Ru, size));
+    for (auto _ : state)
+    {
+        wire::Request req;
+        benchmark::DoNotOptimize(wire::decode_request(payload.data(), payload.size(), req));
+        benchmark::DoNotOptimize(req.text.data());
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(size));
+    state.counters["wire_bytes"] = double(payload.size());
+}
+
+// Результат: ровно те поля, что пишет worker
+static wire::Result sample_result(std::vector<std::string_view> &errors)
+{
+    wire::Result r;
+    r.request_id = kRequestId;
+    r.timestamp = kTimestamp;
+    r.processed_ms = kTimestamp + 12;
+    r.language = "ru";
+    r.score = 72;
+    r.status = "WARN";
+    errors = {"too_many_caps", "low_readability"};
+    r.errors = errors;
+    r.has_metrics = true;
+    for (size_t i = 0; i < wire::kMetricCount; ++i)
+    {
+        if (wire::kMetricFields[i].kind == wire::MetricKind::Int)
+            r.metrics.set_int(i, int64_t(1000 + 37 * i));
+        else
+            r.metrics.set_double(i, 0.1 + 3.7 * double(i));
+    }
+    return r;
+}
+
+static json json_result(const wire::Result &r)
+{
+    json metrics = json::object();
+    for (size_t i = 0; i < wire::kMetricCount; ++i)
+    {
+        if (wire::kMetricFields[i].kind == wire::MetricKind::Int)
+            metrics[wire::kMetricFields[i].name] = r.metrics.get_int(i);
+        else
+            metrics[wire::kMetricFields[i].name] = r.metrics.get_double(i);
+    }
+    return json{{"request_id", r.request_id},
+                {"timestamp", r.timestamp},
+                {"processed_ms", r.processed_ms},
+                {"language", r.language},
+                {"score", r.score},
+                {"status", r.status},
+                {"errors", r.errors},
+                {"metrics", std::move(metrics)}};
+}
+
+static void bm_result_json_dump(benchmark::State &state)
+{
+    std::vector<std::string_view> errors;
+    const wire::Result r = sample_result(errors);
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        std::string payload = json_result(r).dump();
+        bytes = payload.size();
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.counters["wire_bytes"] = double(bytes);
+}
+
+static void bm_result_binary_encode(benchmark::State &state)
+{
+    std::vector<std::string_view> errors;
+    const wire::Result r = sample_result(errors);
+    std::string payload;
+    for (auto _ : state)
+    {
+        wire::encode_result(r, payload);
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.counters["wire_bytes"] = double(payload.size());
+}
+
+// gateway: бинарный результат -> JSON-тело для кэша
+static void bm_result_binary_to_json(benchmark::State &state)
+{
+    std::vector<std::string_view> errors;
+    std::string payload;
+    wire::encode_result(sample_result(errors), payload);
+    std::string body;
+    for (auto _ : state)
+    {
+        wire::Result r;
+        benchmark::DoNotOptimize(wire::decode_result(payload.data(), payload.size(), r));
+        wire::result_to_json(r, body);
+        benchmark::DoNotOptimize(body.data());
+    }
+    state.counters["wire_bytes"] = double(payload.size());
+}
+
+// JsonScanner (gateway) должен принимать ровно те документы, что и nlohmann в worker:
+// иначе gateway отвечает 200 на запрос, который worker не разберёт.
+static bool scanner_agrees_with_nlohmann()
+{
+    static const char *kDocs[] = {
+        R"({"text":"a\u0431b"})",
+        R"({"text":"\ud83d\ude00"})",
+        R"({"text":"a\ud800b"})",
+        R"({"text":"x\udc00"})",
+        R"({"text":"\ud800"})",
+        R"({"text":"\ud800\u0041"})",
+        R"({"text":"\ud800\ud800"})",
+        R"({"text":"\udbff\udfff"})",
+        R"({"text":"\u12"})",
+        R"({"n":0})",
+        R"({"n":-0})",
+        R"({"n":01})",
+        R"({"n":-01})",
+        R"({"n":10})",
+        R"({"n":0.5})",
+        R"({"n":00.5})",
+        R"({"n":1e05})",
+        R"({"n":1.})",
+        R"({"n":-})",
+        R"({"a":[1,{"b":null}],"c":true})",
+        R"({"a":[1,]})",
+    };
+    bool ok = true;
+    for (const char *doc : kDocs)
+    {
+        const bool scanner = JsonScanner(doc, std::char_traits<char>::length(doc)).for_each_member([](std::string_view, std::string_view) {});
+        const bool reference = json::accept(doc);
+        if (scanner != reference)
+        {
+            std::cerr << "JsonScanner mismatch on " << doc << ": scanner=" << scanner
+                      << " nlohmann=" << reference << "\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (!scanner_agrees_with_nlohmann())
+        return 1;
+
+    for (size_t size : kSizes)
+    {
+        const std::string suffix = "/" + std::to_string(size);
+        benchmark::RegisterBenchmark(("request/json_dump" + suffix).c_str(), bm_request_json_dump, size);
+        benchmark::RegisterBenchmark(("request/json_parse" + suffix).c_str(), bm_request_json_parse, size);
+        benchmark::RegisterBenchmark(("request/binary_encode" + suffix).c_str(), bm_request_binary_encode, size);
+        benchmark::RegisterBenchmark(("request/binary_decode" + suffix).c_str(), bm_request_binary_decode, size);
+    }
+    benchmark::RegisterBenchmark("result/json_dump", bm_result_json_dump);
+    benchmark::RegisterBenchmark("result/binary_encode", bm_result_binary_encode);
+    benchmark::RegisterBenchmark("result/binary_to_json", bm_result_binary_to_json);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
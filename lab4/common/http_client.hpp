@@ -0,0 +1,210 @@
+#pragma once
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Минимальный блокирующий HTTP/1.1-клиент для измерительных утилит: одно
+// keep-alive соединение, тело ответа -- только с Content-Length (так отвечает gateway).
+// Не потокобезопасен: по клиенту на поток.
+class HttpClient
+{
+public:
+    struct Response
+    {
+        int status = 0;
+        std::string body;
+    };
+
+    HttpClient(std::string host, uint16_t port) : host_(std::move(host)), port_(port) {}
+    ~HttpClient() { disconnect(); }
+
+    HttpClient(const HttpClient &) = delete;
+    HttpClient &operator=(const HttpClient &) = delete;
+
+    // "host:port" -> host, port; false при ошибке формата
+    static bool parse_address(std::string_view addr, std::string &host, uint16_t &port)
+    {
+        if (addr.substr(0, 7) == "http://")
+            addr.remove_prefix(7);
+        const size_t slash = addr.find('/');
+        if (slash != std::string_view::npos)
+            addr = addr.substr(0, slash);
+        const size_t colon = addr.rfind(':');
+        if (colon == std::string_view::npos || colon == 0)
+            return false;
+        const long p = std::strtol(std::string(addr.substr(colon + 1)).c_str(), nullptr, 10);
+        if (p <= 0 || p > 65535)
+            return false;
+        host.assign(addr.data(), colon);
+        port = static_cast<uint16_t>(p);
+        return true;
+    }
+
+    // Запрос с повтором на новом соединении, если старое закрыл сервер.
+    bool request(const char *method, std::string_view path, std::string_view body, Response &out)
+    {
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            const bool fresh = fd_ < 0;
+            if (fresh && !connect())
+                return false;
+            if (send_request(method, path, body) && read_response(out))
+                return true;
+            disconnect();
+            if (fresh)
+                return false;
+        }
+        return false;
+    }
+
+    bool post(std::string_view path, std::string_view body, Response &out) { return request("POST", path, body, out); }
+    bool get(std::string_view path, Response &out) { return request("GET", path, {}, out); }
+
+private:
+    bool connect()
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *res = nullptr;
+        if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &res) != 0)
+            return false;
+        for (addrinfo *ai = res; ai; ai = ai->ai_next)
+        {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0)
+                continue;
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                fd_ = fd;
+                break;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(res);
+        buf_.clear();
+        return fd_ >= 0;
+    }
+
+    void disconnect()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+        fd_ = -1;
+        buf_.clear();
+    }
+
+    bool send_all(const char *p, size_t n)
+    {
+        while (n > 0)
+        {
+            ssize_t k = ::send(fd_, p, n, MSG_NOSIGNAL);
+            if (k < 0 && errno == EINTR)
+                continue;
+            if (k <= 0)
+                return false;
+            p += k;
+            n -= static_cast<size_t>(k);
+        }
+        return true;
+    }
+
+    bool send_request(const char *method, std::string_view path, std::string_view body)
+    {
+        req_.clear();
+        req_.append(method).append(" ").append(path).append(" HTTP/1.1\r\nHost: ").append(host_);
+        if (!body.empty() || std::strcmp(method, "POST") == 0)
+        {
+            req_.append("\r\nContent-Type: application/json\r\nContent-Length: ");
+            req_.append(std::to_string(body.size()));
+        }
+        req_.append("\r\n\r\n");
+        // тело отдельным send: не копируем большие тексты в буфер запроса
+        return send_all(req_.data(), req_.size()) && send_all(body.data(), body.size());
+    }
+
+    // дочитывает в buf_ не меньше n байт
+    bool fill(size_t n)
+    {
+        char tmp[16384];
+        while (buf_.size() < n)
+        {
+            ssize_t k = ::recv(fd_, tmp, sizeof(tmp), 0);
+            if (k < 0 && errno == EINTR)
+                continue;
+            if (k <= 0)
+                return false;
+            buf_.append(tmp, static_cast<size_t>(k));
+        }
+        return true;
+    }
+
+    bool read_response(Response &out)
+    {
+        size_t head_end;
+        while ((head_end = buf_.find("\r\n\r\n")) == std::string::npos)
+        {
+            if (!fill(buf_.size() + 1))
+                return false;
+        }
+        std::string_view head(buf_.data(), head_end);
+        // HTTP/1.1 200 OK
+        const size_t sp = head.find(' ');
+        if (sp == std::string_view::npos)
+            return false;
+        out.status = std::atoi(std::string(head.substr(sp + 1, 3)).c_str());
+
+        size_t content_length = 0;
+        bool close_after = false;
+        size_t line = head.find("\r\n");
+        while (line != std::string_view::npos)
+        {
+            const size_t next = head.find("\r\n", line + 2);
+            std::string_view h = head.substr(line + 2, next == std::string_view::npos ? std::string_view::npos : next - line - 2);
+            const size_t colon = h.find(':');
+            if (colon != std::string_view::npos)
+            {
+                std::string name(h.substr(0, colon));
+                for (char &c : name)
+                    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                std::string_view value = h.substr(colon + 1);
+                while (!value.empty() && value.front() == ' ')
+                    value.remove_prefix(1);
+                if (name == "content-length")
+                    content_length = std::strtoull(std::string(value).c_str(), nullptr, 10);
+                else if (name == "connection" && (value == "close" || value == "Close"))
+                    close_after = true;
+            }
+            line = next;
+        }
+
+        const size_t body_start = head_end + 4;
+        if (!fill(body_start + content_length))
+            return false;
+        out.body.assign(buf_, body_start, content_length);
+        buf_.erase(0, body_start + content_length);
+        if (close_after)
+            disconnect();
+        return true;
+    }
+
+    std::string host_;
+    uint16_t port_;
+    int fd_ = -1;
+    std::string buf_;
+    std::string req_;
+};
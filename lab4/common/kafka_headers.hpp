@@ -0,0 +1,14 @@
+#pragma once
+#include <string_view>
+
+#include <librdkafka/rdkafkacpp.h>
+
+// true, если последний заголовок name сообщения равен value.
+inline bool kafka_header_is(RdKafka::Headers *headers, const char *name, std::string_view value)
+{
+    if (!headers)
+        return false;
+    RdKafka::Headers::Header h = headers->get_last(name);
+    return h.err() == RdKafka::ERR_NO_ERROR && h.value() != nullptr &&
+           std::string_view(static_cast<const char *>(h.value()), h.value_size()) == value;
+}
@@ -0,0 +1,447 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Бинарный формат сообщений text_requests / text_results (версия 1).
+//
+// Формат выбирается заголовком Kafka: kHeaderFormat = "bin1" -- бинарный payload,
+// заголовка нет -- JSON (старый формат, остаётся запасным). Отправитель запроса
+// пишет kHeaderAccept = "bin1", если примет бинарный результат; иначе worker
+// отвечает JSON.
+//
+// Все числа little-endian. Строки: длина (u8 или u32) + байты UTF-8 без экранирования.
+//
+//   запрос:    'T' 'Q' ver=1 kind=1 | i64 timestamp | u8 id_len id | u8 lang_len lang
+//              | u32 text_len text
+//   результат: 'T' 'Q' ver=1 kind=2 | i64 timestamp | i64 processed_ms | u8 id_len id
+//              | u8 lang_len lang | i32 score | u8 status_len status
+//              | u8 n_errors (u8 len + байты)... | u8 n_metrics (8 байт)...
+//
+// Метрики -- по 8 байт в порядке kMetricFields (int64 или биты double). Читатель
+// берёт известные ему первые поля и пропускает лишние, так что новые метрики
+// дописываются в конец без смены версии.
+
+namespace wire
+{
+inline constexpr const char *kHeaderFormat = "tq-format";
+inline constexpr const char *kHeaderAccept = "tq-accept";
+inline constexpr std::string_view kBinaryV1 = "bin1";
+
+inline constexpr uint8_t kVersion = 1;
+inline constexpr uint8_t kKindRequest = 1;
+inline constexpr uint8_t kKindResult = 2;
+
+enum class MetricKind : uint8_t
+{
+    Int,
+    Double
+};
+
+struct MetricField
+{
+    const char *name;
+    MetricKind kind;
+};
+
+// Порядок -- алфавитный: в нём же поля идут в JSON результата.
+inline constexpr MetricField kMetricFields[] = {
+    {"avg_word_len", MetricKind::Double},
+    {"caps_sequences", MetricKind::Int},
+    {"consecutive_dup_pct", MetricKind::Double},
+    {"exclam_runs", MetricKind::Int},
+    {"junk_chars", MetricKind::Int},
+    {"length_bytes", MetricKind::Int},
+    {"length_chars", MetricKind::Int},
+    {"long_space_runs", MetricKind::Int},
+    {"quest_runs", MetricKind::Int},
+    {"readability", MetricKind::Double},
+    {"sentences", MetricKind::Int},
+    {"unique_word_pct", MetricKind::Double},
+    {"upper_ratio", MetricKind::Double},
+    {"word_count", MetricKind::Int},
+};
+inline constexpr size_t kMetricCount = sizeof(kMetricFields) / sizeof(kMetricFields[0]);
+
+// Индекс поля по имени (на этапе компиляции), для заполнения значений по именам.
+constexpr size_t metric_index(std::string_view name)
+{
+    for (size_t i = 0; i < kMetricCount; ++i)
+        if (name == kMetricFields[i].name)
+            return i;
+    return kMetricCount;
+}
+
+struct MetricValues
+{
+    uint64_t bits[kMetricCount] = {};
+
+    void set_int(size_t i, int64_t v) { bits[i] = static_cast<uint64_t>(v); }
+    void set_double(size_t i, double v) { std::memcpy(&bits[i], &v, sizeof(v)); }
+    int64_t get_int(size_t i) const { return static_cast<int64_t>(bits[i]); }
+    double get_double(size_t i) const
+    {
+        double v;
+        std::memcpy(&v, &bits[i], sizeof(v));
+        return v;
+    }
+};
+
+// Строки ссылаются на payload сообщения (при разборе) или на данные вызывающего.
+struct Request
+{
+    std::string_view request_id;
+    int64_t timestamp = 0;
+    std::string_view language;
+    std::string_view text;
+};
+
+struct Result
+{
+    std::string_view request_id;
+    int64_t timestamp = 0;
+    int64_t processed_ms = 0;
+    std::string_view language;
+    int32_t score = 0;
+    std::string_view status;
+    std::vector<std::string_view> errors;
+    bool has_metrics = false; // false -- "metrics": {}
+    MetricValues metrics;
+};
+
+namespace detail
+{
+inline char *put_u8(char *p, uint8_t v)
+{
+    *p = static_cast<char>(v);
+    return p + 1;
+}
+
+inline char *put_u32(char *p, uint32_t v)
+{
+    for (int k = 0; k < 4; ++k)
+        p[k] = static_cast<char>(v >> (8 * k));
+    return p + 4;
+}
+
+inline char *put_u64(char *p, uint64_t v)
+{
+    for (int k = 0; k < 8; ++k)
+        p[k] = static_cast<char>(v >> (8 * k));
+    return p + 8;
+}
+
+// Строки с префиксом u8 длиннее 255 байт обрезаются.
+inline size_t str8_size(std::string_view s) { return 1 + std::min<size_t>(s.size(), 255); }
+
+inline char *put_str8(char *p, std::string_view s)
+{
+    s = s.substr(0, std::min<size_t>(s.size(), 255));
+    p = put_u8(p, static_cast<uint8_t>(s.size()));
+    std::memcpy(p, s.data(), s.size());
+    return p + s.size();
+}
+
+inline char *put_magic(char *p, uint8_t kind)
+{
+    p[0] = 'T';
+    p[1] = 'Q';
+    p[2] = static_cast<char>(kVersion);
+    p[3] = static_cast<char>(kind);
+    return p + 4;
+}
+
+// Последовательное чтение с проверкой границ: после первой ошибки ok() == false.
+class Reader
+{
+public:
+    Reader(const void *data, size_t size) : p_(static_cast<const unsigned char *>(data)), n_(size) {}
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return i_ == n_; }
+
+    uint8_t u8()
+    {
+        if (!need(1))
+            return 0;
+        return p_[i_++];
+    }
+
+    uint32_t u32()
+    {
+        if (!need(4))
+            return 0;
+        uint32_t v = 0;
+        for (int k = 0; k < 4; ++k)
+            v |= static_cast<uint32_t>(p_[i_ + k]) << (8 * k);
+        i_ += 4;
+        return v;
+    }
+
+    uint64_t u64()
+    {
+        if (!need(8))
+            return 0;
+        uint64_t v = 0;
+        for (int k = 0; k < 8; ++k)
+            v |= static_cast<uint64_t>(p_[i_ + k]) << (8 * k);
+        i_ += 8;
+        return v;
+    }
+
+    std::string_view bytes(size_t len)
+    {
+        if (!need(len))
+            return {};
+        std::string_view s(reinterpret_cast<const char *>(p_ + i_), len);
+        i_ += len;
+        return s;
+    }
+
+    std::string_view str8() { return bytes(u8()); }
+    std::string_view str32() { return bytes(u32()); }
+
+    bool magic(uint8_t kind)
+    {
+        std::string_view m = bytes(4);
+        return ok_ && m[0] == 'T' && m[1] == 'Q' && static_cast<uint8_t>(m[2]) == kVersion &&
+               static_cast<uint8_t>(m[3]) == kind;
+    }
+
+private:
+    bool need(size_t k)
+    {
+        if (!ok_ || n_ - i_ < k)
+        {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    const unsigned char *p_;
+    size_t n_;
+    size_t i_ = 0;
+    bool ok_ = true;
+};
+} // namespace detail
+
+// --- запрос ---
+
+// Заголовок запроса занимает request_header_size байт, сразу за ним -- text_len байт текста.
+// Так текст можно записать (например, раскрыть из JSON) прямо в итоговый буфер.
+inline size_t request_header_size(std::string_view request_id, std::string_view language)
+{
+    return 4 + 8 + detail::str8_size(request_id) + detail::str8_size(language) + 4;
+}
+
+inline char *write_request_header(char *out, std::string_view request_id, int64_t timestamp,
+                                  std::string_view language, uint32_t text_len)
+{
+    using namespace detail;
+    char *p = put_magic(out, kKindRequest);
+    p = put_u64(p, static_cast<uint64_t>(timestamp));
+    p = put_str8(p, request_id);
+    p = put_str8(p, language);
+    return put_u32(p, text_len);
+}
+
+inline void encode_request(const Request &r, std::string &out)
+{
+    out.resize(request_header_size(r.request_id, r.language) + r.text.size());
+    char *p = write_request_header(out.data(), r.request_id, r.timestamp, r.language,
+                                   static_cast<uint32_t>(r.text.size()));
+    std::memcpy(p, r.text.data(), r.text.size());
+}
+
+// Строки результата указывают в data: текст не копируется.
+inline bool decode_request(const void *data, size_t size, Request &out)
+{
+    detail::Reader r(data, size);
+    if (!r.magic(kKindRequest))
+        return false;
+    out.timestamp = static_cast<int64_t>(r.u64());
+    out.request_id = r.str8();
+    out.language = r.str8();
+    out.text = r.str32();
+    return r.ok() && r.at_end();
+}
+
+// --- результат ---
+
+inline void encode_result(const Result &res, std::string &out)
+{
+    using namespace detail;
+    const size_t n_errors = std::min<size_t>(res.errors.size(), 255);
+    size_t size = 4 + 8 + 8 + str8_size(res.request_id) + str8_size(res.language) + 4 + str8_size(res.status) + 1 + 1;
+    for (size_t i = 0; i < n_errors; ++i)
+        size += str8_size(res.errors[i]);
+    const size_t n_metrics = res.has_metrics ? kMetricCount : 0;
+    size += 8 * n_metrics;
+
+    out.resize(size);
+    char *p = put_magic(out.data(), kKindResult);
+    p = put_u64(p, static_cast<uint64_t>(res.timestamp));
+    p = put_u64(p, static_cast<uint64_t>(res.processed_ms));
+    p = put_str8(p, res.request_id);
+    p = put_str8(p, res.language);
+    p = put_u32(p, static_cast<uint32_t>(res.score));
+    p = put_str8(p, res.status);
+    p = put_u8(p, static_cast<uint8_t>(n_errors));
+    for (size_t i = 0; i < n_errors; ++i)
+        p = put_str8(p, res.errors[i]);
+    p = put_u8(p, static_cast<uint8_t>(n_metrics));
+    for (size_t i = 0; i < n_metrics; ++i)
+        p = put_u64(p, res.metrics.bits[i]);
+}
+
+inline bool decode_result(const void *data, size_t size, Result &out)
+{
+    detail::Reader r(data, size);
+    if (!r.magic(kKindResult))
+        return false;
+    out.timestamp = static_cast<int64_t>(r.u64());
+    out.processed_ms = static_cast<int64_t>(r.u64());
+    out.request_id = r.str8();
+    out.language = r.str8();
+    out.score = static_cast<int32_t>(r.u32());
+    out.status = r.str8();
+    const size_t n_errors = r.u8();
+    out.errors.clear();
+    for (size_t i = 0; i < n_errors && r.ok(); ++i)
+        out.errors.push_back(r.str8());
+    const size_t n_metrics = r.u8();
+    out.has_metrics = n_metrics > 0;
+    out.metrics = MetricValues{};
+    for (size_t i = 0; i < n_metrics && r.ok(); ++i)
+    {
+        const uint64_t v = r.u64();
+        if (i < kMetricCount)
+            out.metrics.bits[i] = v;
+    }
+    return r.ok() && r.at_end();
+}
+
+// --- JSON результата (тот же вид, что у JSON-ответа worker: ключи по алфавиту) ---
+
+namespace detail
+{
+inline void append_json_string(std::string &out, std::string_view s)
+{
+    static const char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (char c : s)
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\b':
+            out += "\\b";
+            break;
+        case '\f':
+            out += "\\f";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (u < 0x20)
+            {
+                out += "\\u00";
+                out.push_back(kHex[u >> 4]);
+                out.push_back(kHex[u & 0xF]);
+            }
+            else
+            {
+                out.push_back(c);
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+inline void append_int(std::string &out, int64_t v)
+{
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, static_cast<size_t>(r.ptr - buf));
+}
+
+// Кратчайшее точное представление; целые значения -- с ".0", не-числа -- null.
+inline void append_double(std::string &out, double v)
+{
+    if (!std::isfinite(v))
+    {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    const std::string_view s(buf, static_cast<size_t>(r.ptr - buf));
+    out += s;
+    if (s.find_first_of(".e") == std::string_view::npos)
+        out += ".0";
+}
+} // namespace detail
+
+inline void result_to_json(const Result &res, std::string &out)
+{
+    using namespace detail;
+    out.clear();
+    out.reserve(512);
+    out += "{\"errors\":[";
+    for (size_t i = 0; i < res.errors.size(); ++i)
+    {
+        if (i)
+            out.push_back(',');
+        append_json_string(out, res.errors[i]);
+    }
+    out += "],\"language\":";
+    append_json_string(out, res.language);
+    out += ",\"metrics\":{";
+    if (res.has_metrics)
+    {
+        for (size_t i = 0; i < kMetricCount; ++i)
+        {
+            if (i)
+                out.push_back(',');
+            out.push_back('"');
+            out += kMetricFields[i].name;
+            out += "\":";
+            if (kMetricFields[i].kind == MetricKind::Int)
+                append_int(out, res.metrics.get_int(i));
+            else
+                append_double(out, res.metrics.get_double(i));
+        }
+    }
+    out += "},\"processed_ms\":";
+    append_int(out, res.processed_ms);
+    out += ",\"request_id\":";
+    append_json_string(out, res.request_id);
+    out += ",\"score\":";
+    append_int(out, res.score);
+    out += ",\"status\":";
+    append_json_string(out, res.status);
+    out += ",\"timestamp\":";
+    append_int(out, res.timestamp);
+    out.push_back('}');
+}
+} // namespace wire
@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Контроль допуска /check и /check/batch: gateway отказывает (429) сразу,
+// не дожидаясь QUEUE_FULL от librdkafka и роста памяти под очередь producer.
+//
+// Порядок проверок -- от дешёвых к дорогим, токены списываются последними:
+//   1. очередь producer: сообщений (outq_len) и байт (учитываются здесь же:
+//      +len при постановке в очередь, -len в отчёте о доставке);
+//   2. задержка доставки: скользящее среднее latency() из отчётов о доставке,
+//      учитывается только пока в очереди что-то есть -- иначе после затора
+//      среднее некому было бы обновить;
+//   3. token bucket по числу текстов в секунду (GCRA: одно атомарное
+//      "теоретическое время прибытия", без локов).
+struct AdmissionOptions
+{
+    double rate = 0;                   // текстов/с; 0 -- без ограничения
+    double burst = 1000;               // ёмкость bucket в текстах
+    size_t max_queue_messages = 50000; // 0 -- без ограничения
+    size_t max_queue_bytes = 64u << 20;
+    int64_t max_delivery_ms = 5000;    // 0 -- не учитывать
+    int retry_after_s = 1;             // Retry-After при переполнении очереди
+};
+
+class AdmissionControl
+{
+public:
+    enum class Verdict
+    {
+        Admit,
+        RateLimited,
+        QueueMessages,
+        QueueBytes,
+        SlowDelivery,
+        ProducerQueueFull
+    };
+
+    struct Decision
+    {
+        Verdict verdict = Verdict::Admit;
+        int retry_after_s = 0;
+
+        explicit operator bool() const { return verdict == Verdict::Admit; }
+    };
+
+    explicit AdmissionControl(AdmissionOptions opts)
+        : opts_(opts),
+          interval_ns_(opts.rate > 0 ? static_cast<int64_t>(1e9 / opts.rate) : 0),
+          tolerance_ns_(static_cast<int64_t>(std::max(1.0, opts.burst) * double(interval_ns_))) {}
+
+    // n текстов общим объёмом bytes; queued_messages -- текущая длина очереди
+    // producer (или пула в режиме inprocess). Либо допускаются все n, либо ни один.
+    Decision admit(size_t n, size_t bytes, size_t queued_messages)
+    {
+        if (opts_.max_queue_messages > 0 && queued_messages + n > opts_.max_queue_messages)
+            return {Verdict::QueueMessages, opts_.retry_after_s};
+        const size_t inflight = inflight_bytes_.load(std::memory_order_relaxed);
+        if (opts_.max_queue_bytes > 0 && inflight + bytes > opts_.max_queue_bytes)
+            return {Verdict::QueueBytes, opts_.retry_after_s};
+        if (opts_.max_delivery_ms > 0 && queued_messages > 0 &&
+            delivery_avg_us_.load(std::memory_order_relaxed) > opts_.max_delivery_ms * 1000)
+            return {Verdict::SlowDelivery, opts_.retry_after_s};
+        if (interval_ns_ == 0)
+            return {};
+
+        // GCRA: tat -- момент, когда bucket снова станет полным
+        const int64_t now = now_ns();
+        const int64_t cost = static_cast<int64_t>(n) * interval_ns_;
+        const int64_t limit = std::max(tolerance_ns_, cost); // пачка больше burst проходит в полный bucket
+        int64_t tat = tat_ns_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            const int64_t next = std::max(tat, now) + cost;
+            if (next - now > limit)
+            {
+                const int64_t wait_ns = next - now - limit;
+                return {Verdict::RateLimited, static_cast<int>(std::max<int64_t>(1, (wait_ns + 999999999) / 1000000000))};
+            }
+            if (tat_ns_.compare_exchange_weak(tat, next, std::memory_order_relaxed))
+                return {};
+        }
+    }
+
+    // librdkafka всё же вернул QUEUE_FULL: отказ тот же, что и по пределам очереди.
+    Decision producer_queue_full() const { return {Verdict::ProducerQueueFull, opts_.retry_after_s}; }
+
+    // Сообщение принято в очередь producer.
+    void on_enqueued(size_t bytes) { inflight_bytes_.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // Отчёт о доставке (успешной или нет): сообщение покинуло очередь.
+    void on_delivered(size_t bytes, int64_t latency_us)
+    {
+        inflight_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        if (latency_us < 0)
+            return;
+        // poll() зовут и HTTP-потоки, так что отчёты могут прийти параллельно; вес нового -- 1/8
+        int64_t avg = delivery_avg_us_.load(std::memory_order_relaxed);
+        while (!delivery_avg_us_.compare_exchange_weak(avg, avg + (latency_us - avg) / 8, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    size_t inflight_bytes() const { return inflight_bytes_.load(std::memory_order_relaxed); }
+    int64_t delivery_avg_us() const { return delivery_avg_us_.load(std::memory_order_relaxed); }
+
+    static const char *reason(Verdict v)
+    {
+        switch (v)
+        {
+        case Verdict::Admit:
+            return "admit";
+        case Verdict::RateLimited:
+            return "rate limit";
+        case Verdict::QueueMessages:
+            return "producer queue full (messages)";
+        case Verdict::QueueBytes:
+            return "producer queue full (bytes)";
+        case Verdict::SlowDelivery:
+            return "kafka delivery too slow";
+        case Verdict::ProducerQueueFull:
+            return "librdkafka queue full";
+        }
+        return "unknown";
+    }
+
+private:
+    static int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    const AdmissionOptions opts_;
+    const int64_t interval_ns_;  // стоимость одного текста
+    const int64_t tolerance_ns_; // burst * interval
+    std::atomic<int64_t> tat_ns_{0};
+    std::atomic<size_t> inflight_bytes_{0};
+    std::atomic<int64_t> delivery_avg_us_{0};
+};
@@ -0,0 +1,391 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Асинхронный логгер: запись строки -- форматирование key=value прямо в слот
+// кольцевого буфера (bounded MPMC, Vyukov) без локов и аллокаций; вывод в
+// stdout/stderr делает фоновый поток. При заполненном буфере запись
+// отбрасывается и учитывается в счётчике -- потоки запросов никогда не ждут stdout.
+//
+// Строка: ts=<epoch ms> level=<lvl> app=<name> event=<event> k=v ...
+// Warn и Error уходят в stderr, остальное -- в stdout.
+
+enum class LogLevel
+{
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+    Off = 4
+};
+
+inline LogLevel parse_log_level(const std::string &s, LogLevel defv)
+{
+    if (s == "debug")
+        return LogLevel::Debug;
+    if (s == "info")
+        return LogLevel::Info;
+    if (s == "warn")
+        return LogLevel::Warn;
+    if (s == "error")
+        return LogLevel::Error;
+    if (s == "off")
+        return LogLevel::Off;
+    return defv;
+}
+
+inline const char *log_level_name(LogLevel l)
+{
+    switch (l)
+    {
+    case LogLevel::Debug:
+        return "debug";
+    case LogLevel::Info:
+        return "info";
+    case LogLevel::Warn:
+        return "warn";
+    case LogLevel::Error:
+        return "error";
+    default:
+        return "off";
+    }
+}
+
+// Значение поля; хранит ссылку на данные, поэтому живёт только на время вызова write().
+struct LogField
+{
+    enum class Kind
+    {
+        Int,
+        Uint,
+        Double,
+        Str
+    };
+
+    LogField(const char *k, int v) : key(k), kind(Kind::Int), i(v) {}
+    LogField(const char *k, long v) : key(k), kind(Kind::Int), i(v) {}
+    LogField(const char *k, long long v) : key(k), kind(Kind::Int), i(v) {}
+    LogField(const char *k, unsigned v) : key(k), kind(Kind::Uint), u(v) {}
+    LogField(const char *k, unsigned long v) : key(k), kind(Kind::Uint), u(v) {}
+    LogField(const char *k, unsigned long long v) : key(k), kind(Kind::Uint), u(v) {}
+    LogField(const char *k, double v) : key(k), kind(Kind::Double), d(v) {}
+    LogField(const char *k, std::string_view v) : key(k), kind(Kind::Str), s(v) {}
+    LogField(const char *k, const std::string &v) : key(k), kind(Kind::Str), s(v) {}
+    LogField(const char *k, const char *v) : key(k), kind(Kind::Str), s(v ? v : "") {}
+
+    const char *key;
+    Kind kind;
+    int64_t i = 0;
+    uint64_t u = 0;
+    double d = 0;
+    std::string_view s;
+};
+
+struct LogOptions
+{
+    LogLevel level = LogLevel::Info;
+    unsigned sample_every = 1; // Debug/Info: пишется каждая N-я запись потока
+    size_t ring_slots = 8192;  // округляется вверх до степени двойки
+};
+
+class AsyncLogger
+{
+public:
+    static constexpr size_t kSlotBytes = 512 - 2 * sizeof(uint64_t);
+
+    AsyncLogger(std::string app, LogOptions opts)
+        : app_(std::move(app)), level_(opts.level), sample_every_(opts.sample_every ? opts.sample_every : 1)
+    {
+        size_t n = 2;
+        while (n < opts.ring_slots)
+            n <<= 1;
+        mask_ = n - 1;
+        slots_.reset(new Slot[n]);
+        for (size_t i = 0; i < n; ++i)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        flusher_ = std::thread([this]
+                               { flush_loop(); });
+    }
+
+    ~AsyncLogger()
+    {
+        stop();
+    }
+
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    bool enabled(LogLevel l) const { return l >= level_ && l != LogLevel::Off; }
+
+    void write(LogLevel l, const char *event, std::initializer_list<LogField> fields = {})
+    {
+        if (!enabled(l))
+            return;
+        if (l < LogLevel::Warn && sample_every_ > 1)
+        {
+            thread_local unsigned counter = 0;
+            if (counter++ % sample_every_ != 0)
+                return;
+        }
+
+        const int64_t ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+
+        // резервируем слот
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot *slot = nullptr;
+        while (true)
+        {
+            slot = &slots_[pos & mask_];
+            const size_t seq = slot->seq.load(std::memory_order_acquire);
+            const intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        LineWriter w{slot->text, 0};
+        w.put("ts=");
+        w.put_int(ts);
+        w.put(" level=");
+        w.put(log_level_name(l));
+        w.put(" app=");
+        w.put(app_);
+        w.put(" event=");
+        w.put_value(event);
+        for (const LogField &f : fields)
+        {
+            w.put(' ');
+            w.put(f.key);
+            w.put('=');
+            switch (f.kind)
+            {
+            case LogField::Kind::Int:
+                w.put_int(f.i);
+                break;
+            case LogField::Kind::Uint:
+                w.put_uint(f.u);
+                break;
+            case LogField::Kind::Double:
+                w.put_double(f.d);
+                break;
+            case LogField::Kind::Str:
+                w.put_value(f.s);
+                break;
+            }
+        }
+        slot->len = static_cast<uint32_t>(w.finish());
+        slot->level = static_cast<uint32_t>(l);
+        slot->seq.store(pos + 1, std::memory_order_release);
+    }
+
+    void debug(const char *event, std::initializer_list<LogField> fields = {}) { write(LogLevel::Debug, event, fields); }
+    void info(const char *event, std::initializer_list<LogField> fields = {}) { write(LogLevel::Info, event, fields); }
+    void warn(const char *event, std::initializer_list<LogField> fields = {}) { write(LogLevel::Warn, event, fields); }
+    void error(const char *event, std::initializer_list<LogField> fields = {}) { write(LogLevel::Error, event, fields); }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Дописывает всё накопленное и останавливает фоновый поток.
+    void stop()
+    {
+        if (stop_.exchange(true))
+            return;
+        if (flusher_.joinable())
+            flusher_.join();
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<size_t> seq{0};
+        uint32_t len = 0;
+        uint32_t level = 0;
+        char text[kSlotBytes];
+    };
+
+    // Форматирование в фиксированный буфер; не помещающееся обрезается с "...".
+    struct LineWriter
+    {
+        char *buf;
+        size_t n;
+        static constexpr size_t kCap = kSlotBytes - 1; // место под '\n'
+
+        void put(char c)
+        {
+            if (n < kCap)
+                buf[n] = c;
+            n++;
+        }
+
+        void put(std::string_view s)
+        {
+            if (n < kCap)
+                std::memcpy(buf + n, s.data(), std::min(s.size(), kCap - n));
+            n += s.size();
+        }
+
+        void put_int(int64_t v)
+        {
+            char tmp[24];
+            auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            put(std::string_view(tmp, static_cast<size_t>(r.ptr - tmp)));
+        }
+
+        void put_uint(uint64_t v)
+        {
+            char tmp[24];
+            auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            put(std::string_view(tmp, static_cast<size_t>(r.ptr - tmp)));
+        }
+
+        void put_double(double v)
+        {
+            char tmp[32];
+            int len = std::snprintf(tmp, sizeof(tmp), "%.6g", v);
+            put(std::string_view(tmp, len > 0 ? static_cast<size_t>(len) : 0));
+        }
+
+        // Значения с пробелами, кавычками, '=' или управляющими символами берутся в кавычки.
+        void put_value(std::string_view s)
+        {
+            bool quote = s.empty();
+            for (char c : s)
+            {
+                if (c == ' ' || c == '"' || c == '=' || c == '\\' || static_cast<unsigned char>(c) < 0x20)
+                {
+                    quote = true;
+                    break;
+                }
+            }
+            if (!quote)
+                return put(s);
+            put('"');
+            for (char c : s)
+            {
+                if (n >= kCap)
+                    break;
+                if (c == '"' || c == '\\')
+                {
+                    put('\\');
+                    put(c);
+                }
+                else if (c == '\n')
+                    put("\\n");
+                else if (static_cast<unsigned char>(c) < 0x20)
+                    put(' ');
+                else
+                    put(c);
+            }
+            put('"');
+        }
+
+        size_t finish()
+        {
+            if (n > kCap)
+            {
+                n = kCap;
+                std::memcpy(buf + kCap - 3, "...", 3);
+            }
+            buf[n++] = '\n';
+            return n;
+        }
+    };
+
+    void flush_loop()
+    {
+        std::string out, err;
+        out.reserve(64 << 10);
+        err.reserve(16 << 10);
+        uint64_t reported_dropped = 0;
+
+        while (true)
+        {
+            const bool stopping = stop_.load(std::memory_order_acquire);
+            size_t taken = 0;
+            while (taken < 4096)
+            {
+                Slot &slot = slots_[dequeue_pos_ & mask_];
+                if (slot.seq.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+                    break;
+                std::string &dst = slot.level >= static_cast<uint32_t>(LogLevel::Warn) ? err : out;
+                dst.append(slot.text, slot.len);
+                slot.seq.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+                dequeue_pos_++;
+                taken++;
+            }
+
+            const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped)
+            {
+                char line[128];
+                int len = std::snprintf(line, sizeof(line), "ts=%lld level=warn app=%s event=log_dropped count=%llu\n",
+                                        static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                                   std::chrono::system_clock::now().time_since_epoch())
+                                                                   .count()),
+                                        app_.c_str(), static_cast<unsigned long long>(dropped - reported_dropped));
+                if (len > 0)
+                    err.append(line, std::min(static_cast<size_t>(len), sizeof(line) - 1));
+                reported_dropped = dropped;
+            }
+
+            if (!out.empty())
+            {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                std::fflush(stdout);
+                out.clear();
+            }
+            if (!err.empty())
+            {
+                std::fwrite(err.data(), 1, err.size(), stderr);
+                std::fflush(stderr);
+                err.clear();
+            }
+
+            if (taken == 0)
+            {
+                // stop_ прочитан до опустошения: всё записанное раньше stop() уже выведено
+                if (stopping)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(kIdleSleepMs));
+            }
+        }
+    }
+
+    static constexpr int kIdleSleepMs = 2;
+
+    const std::string app_;
+    const LogLevel level_;
+    const unsigned sample_every_;
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0; // только поток вывода
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> stop_{false};
+    std::thread flusher_;
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <dirent.h>
+#include <sched.h>
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Привязка потоков к ядрам по имени. Pistache не отдаёт свои потоки наружу,
+// но называет их по Endpoint::Options::threadsName: они находятся в /proc/self/task.
+
+// Ядра, разрешённые процессу (учитывает cpuset контейнера и taskset).
+inline std::vector<int> allowed_cpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return cpus;
+    for (int c = 0; c < CPU_SETSIZE; ++c)
+    {
+        if (CPU_ISSET(c, &set))
+            cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// tid потоков процесса, чьё имя начинается с prefix (имя обрезается ядром до 15 байт).
+inline std::vector<pid_t> threads_named(const std::string &prefix)
+{
+    std::vector<pid_t> tids;
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir)
+        return tids;
+    while (dirent *e = readdir(dir))
+    {
+        if (e->d_name[0] == '.')
+            continue;
+        std::ifstream comm(std::string("/proc/self/task/") + e->d_name + "/comm");
+        std::string name;
+        if (std::getline(comm, name) && name.compare(0, prefix.size(), prefix) == 0)
+            tids.push_back(static_cast<pid_t>(std::stol(e->d_name)));
+    }
+    closedir(dir);
+    return tids;
+}
+
+// Раскладывает expected потоков с именем prefix по разрешённым ядрам по кругу,
+// начиная с first_cpu-го из них. Потоки создаются асинхронно после старта сервера,
+// поэтому ждём их появления до wait. Возвращает число привязанных потоков.
+inline size_t pin_threads_by_name(const std::string &prefix, size_t expected, size_t first_cpu,
+                                  std::chrono::milliseconds wait = std::chrono::milliseconds(1000))
+{
+    const std::vector<int> cpus = allowed_cpus();
+    if (cpus.empty())
+        return 0;
+    std::vector<pid_t> tids = threads_named(prefix);
+    const auto deadline = std::chrono::steady_clock::now() + wait;
+    while (tids.size() < expected && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        tids = threads_named(prefix);
+    }
+
+    size_t pinned = 0;
+    for (size_t i = 0; i < tids.size(); ++i)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[(first_cpu + i) % cpus.size()], &set);
+        if (sched_setaffinity(tids[i], sizeof(set), &set) == 0)
+            pinned++;
+    }
+    return pinned;
+}
@@ -0,0 +1,403 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Лёгкий проход по JSON без построения DOM: проверяет структуру и отдаёт
+// сырые срезы (string_view на исходный буфер) для членов объекта верхнего уровня.
+// Нужен там, где из сообщения требуется одно-два поля, а остальное передаётся дальше как есть.
+class JsonScanner
+{
+public:
+    static constexpr int kMaxDepth = 64;
+
+    JsonScanner(const char *data, size_t size) : p_(data), n_(size) {}
+    explicit JsonScanner(std::string_view s) : p_(s.data()), n_(s.size()) {}
+
+    // f(key, value) для каждого члена объекта верхнего уровня.
+    // key -- содержимое строки ключа без кавычек (escape-последовательности не раскрыты),
+    // value -- сырой срез значения (строки -- вместе с кавычками).
+    // false -- документ не является корректным JSON-объектом.
+    template <class F>
+    bool for_each_member(F &&f)
+    {
+        i_ = 0;
+        skip_ws();
+        if (!eat('{'))
+            return false;
+        skip_ws();
+        if (eat('}'))
+            return at_end();
+
+        while (true)
+        {
+            size_t kb = 0, ke = 0;
+            if (!scan_string(kb, ke))
+                return false;
+            skip_ws();
+            if (!eat(':'))
+                return false;
+            skip_ws();
+            size_t vb = i_;
+            if (!skip_value(1))
+                return false;
+            f(std::string_view(p_ + kb, ke - kb), std::string_view(p_ + vb, i_ - vb));
+            skip_ws();
+            if (eat(','))
+            {
+                skip_ws();
+                continue;
+            }
+            if (eat('}'))
+                return at_end();
+            return false;
+        }
+    }
+
+private:
+    bool at_end()
+    {
+        skip_ws();
+        return i_ == n_;
+    }
+
+    void skip_ws()
+    {
+        while (i_ < n_ && (p_[i_] == ' ' || p_[i_] == '\t' || p_[i_] == '\n' || p_[i_] == '\r'))
+            ++i_;
+    }
+
+    bool eat(char c)
+    {
+        if (i_ < n_ && p_[i_] == c)
+        {
+            ++i_;
+            return true;
+        }
+        return false;
+    }
+
+    static bool is_hex(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    // Четыре hex-цифры \uXXXX с позиции at; за ними в строке ещё должен быть хотя бы один символ.
+    bool scan_hex4(size_t at, uint32_t &v) const
+    {
+        if (at + 4 >= n_)
+            return false;
+        v = 0;
+        for (size_t k = 0; k < 4; ++k)
+        {
+            char c = p_[at + k];
+            if (!is_hex(c))
+                return false;
+            v = (v << 4) | static_cast<uint32_t>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+        }
+        return true;
+    }
+
+    // Длина корректной UTF-8 последовательности с позиции at, 0 -- некорректная
+    // (обрезанная, overlong, суррогат или больше U+10FFFF).
+    size_t utf8_seq_len(size_t at) const
+    {
+        auto byte = [&](size_t k)
+        { return static_cast<unsigned char>(p_[at + k]); };
+        auto cont = [&](size_t k, unsigned char lo = 0x80, unsigned char hi = 0xBF)
+        { return at + k < n_ && byte(k) >= lo && byte(k) <= hi; };
+
+        unsigned char c = byte(0);
+        if (c >= 0xC2 && c <= 0xDF)
+            return cont(1) ? 2 : 0;
+        if (c == 0xE0)
+            return cont(1, 0xA0, 0xBF) && cont(2) ? 3 : 0;
+        if ((c >= 0xE1 && c <= 0xEC) || c == 0xEE || c == 0xEF)
+            return cont(1) && cont(2) ? 3 : 0;
+        if (c == 0xED)
+            return cont(1, 0x80, 0x9F) && cont(2) ? 3 : 0;
+        if (c == 0xF0)
+            return cont(1, 0x90, 0xBF) && cont(2) && cont(3) ? 4 : 0;
+        if (c >= 0xF1 && c <= 0xF3)
+            return cont(1) && cont(2) && cont(3) ? 4 : 0;
+        if (c == 0xF4)
+            return cont(1, 0x80, 0x8F) && cont(2) && cont(3) ? 4 : 0;
+        return 0;
+    }
+
+    // [b, e) -- содержимое строки без кавычек; UTF-8 проверяется
+    bool scan_string(size_t &b, size_t &e)
+    {
+        if (!eat('"'))
+            return false;
+        b = i_;
+        while (i_ < n_)
+        {
+            unsigned char c = static_cast<unsigned char>(p_[i_]);
+            if (c == '"')
+            {
+                e = i_++;
+                return true;
+            }
+            if (c < 0x20)
+                return false;
+            if (c >= 0x80)
+            {
+                size_t len = utf8_seq_len(i_);
+                if (len == 0)
+                    return false;
+                i_ += len;
+                continue;
+            }
+            if (c == '\\')
+            {
+                if (++i_ >= n_)
+                    return false;
+                char esc = p_[i_];
+                if (esc == 'u')
+                {
+                    // одиночные суррогаты отвергаются: после раскрытия они дали бы некорректный UTF-8
+                    uint32_t cp = 0;
+                    if (!scan_hex4(i_ + 1, cp) || (cp >= 0xDC00 && cp <= 0xDFFF))
+                        return false;
+                    i_ += 4;
+                    if (cp >= 0xD800 && cp <= 0xDBFF)
+                    {
+                        uint32_t lo = 0;
+                        if (i_ + 2 >= n_ || p_[i_ + 1] != '\\' || p_[i_ + 2] != 'u' ||
+                            !scan_hex4(i_ + 3, lo) || lo < 0xDC00 || lo > 0xDFFF)
+                            return false;
+                        i_ += 6;
+                    }
+                }
+                else if (esc != '"' && esc != '\\' && esc != '/' && esc != 'b' &&
+                         esc != 'f' && esc != 'n' && esc != 'r' && esc != 't')
+                {
+                    return false;
+                }
+            }
+            ++i_;
+        }
+        return false;
+    }
+
+    bool skip_literal(const char *lit, size_t len)
+    {
+        if (n_ - i_ < len || std::string_view(p_ + i_, len) != std::string_view(lit, len))
+            return false;
+        i_ += len;
+        return true;
+    }
+
+    bool skip_number()
+    {
+        size_t b = i_;
+        eat('-');
+        size_t digits = i_;
+        while (i_ < n_ && p_[i_] >= '0' && p_[i_] <= '9')
+            ++i_;
+        if (i_ == digits || (p_[digits] == '0' && i_ - digits > 1)) // ведущие нули запрещены
+            return false;
+        if (eat('.'))
+        {
+            size_t frac = i_;
+            while (i_ < n_ && p_[i_] >= '0' && p_[i_] <= '9')
+                ++i_;
+            if (i_ == frac)
+                return false;
+        }
+        if (i_ < n_ && (p_[i_] == 'e' || p_[i_] == 'E'))
+        {
+            ++i_;
+            if (i_ < n_ && (p_[i_] == '+' || p_[i_] == '-'))
+                ++i_;
+            size_t exp = i_;
+            while (i_ < n_ && p_[i_] >= '0' && p_[i_] <= '9')
+                ++i_;
+            if (i_ == exp)
+                return false;
+        }
+        return i_ > b;
+    }
+
+    bool skip_value(int depth)
+    {
+        if (i_ >= n_ || depth > kMaxDepth)
+            return false;
+        size_t b = 0, e = 0;
+        switch (p_[i_])
+        {
+        case '"':
+            return scan_string(b, e);
+        case 't':
+            return skip_literal("true", 4);
+        case 'f':
+            return skip_literal("false", 5);
+        case 'n':
+            return skip_literal("null", 4);
+        case '{':
+        {
+            ++i_;
+            skip_ws();
+            if (eat('}'))
+                return true;
+            while (true)
+            {
+                if (!scan_string(b, e))
+                    return false;
+                skip_ws();
+                if (!eat(':'))
+                    return false;
+                skip_ws();
+                if (!skip_value(depth + 1))
+                    return false;
+                skip_ws();
+                if (eat(','))
+                {
+                    skip_ws();
+                    continue;
+                }
+                return eat('}');
+            }
+        }
+        case '[':
+        {
+            ++i_;
+            skip_ws();
+            if (eat(']'))
+                return true;
+            while (true)
+            {
+                if (!skip_value(depth + 1))
+                    return false;
+                skip_ws();
+                if (eat(','))
+                {
+                    skip_ws();
+                    continue;
+                }
+                return eat(']');
+            }
+        }
+        default:
+            return skip_number();
+        }
+    }
+
+    const char *p_;
+    size_t n_;
+    size_t i_ = 0;
+};
+
+// Раскрывает escape-последовательности содержимого JSON-строки (без кавычек) в UTF-8.
+// Вход должен быть уже проверен JsonScanner. Пишет в out не больше raw.size() байт
+// (escape всегда длиннее своего UTF-8) и возвращает длину результата.
+inline size_t json_unescape_to(std::string_view raw, char *out)
+{
+    char *o = out;
+    auto hex4 = [&](size_t at)
+    {
+        uint32_t v = 0;
+        for (size_t k = 0; k < 4; ++k)
+        {
+            char c = raw[at + k];
+            v <<= 4;
+            if (c >= '0' && c <= '9')
+                v |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                v |= static_cast<uint32_t>(c - 'a' + 10);
+            else
+                v |= static_cast<uint32_t>(c - 'A' + 10);
+        }
+        return v;
+    };
+
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        char c = raw[i];
+        if (c != '\\')
+        {
+            *o++ = c;
+            continue;
+        }
+        char esc = raw[++i];
+        switch (esc)
+        {
+        case 'b':
+            *o++ = '\b';
+            break;
+        case 'f':
+            *o++ = '\f';
+            break;
+        case 'n':
+            *o++ = '\n';
+            break;
+        case 'r':
+            *o++ = '\r';
+            break;
+        case 't':
+            *o++ = '\t';
+            break;
+        case 'u':
+        {
+            uint32_t cp = hex4(i + 1);
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u')
+            {
+                uint32_t lo = hex4(i + 3);
+                if (lo >= 0xDC00 && lo <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                }
+            }
+            if (cp < 0x80)
+                *o++ = static_cast<char>(cp);
+            else if (cp < 0x800)
+            {
+                *o++ = static_cast<char>(0xC0 | (cp >> 6));
+                *o++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                *o++ = static_cast<char>(0xE0 | (cp >> 12));
+                *o++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *o++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                *o++ = static_cast<char>(0xF0 | (cp >> 18));
+                *o++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                *o++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *o++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            break;
+        }
+        default: // " \ /
+            *o++ = esc;
+            break;
+        }
+    }
+    return static_cast<size_t>(o - out);
+}
+
+inline std::string json_unescape(std::string_view raw)
+{
+    std::string out(raw.size(), '\0');
+    out.resize(json_unescape_to(raw, out.data()));
+    return out;
+}
+
+// Значение-строка из сырого среза JsonScanner ("..." вместе с кавычками).
+inline bool json_string_value(std::string_view raw_value, std::string &out)
+{
+    if (raw_value.size() < 2 || raw_value.front() != '"')
+        return false;
+    std::string_view body = raw_value.substr(1, raw_value.size() - 2);
+    if (body.find('\\') == std::string_view::npos)
+        out.assign(body.data(), body.size());
+    else
+        out = json_unescape(body);
+    return true;
+}
@@ -5,16 +5,35 @@
 #include <nlohmann/json.hpp>
 #include <librdkafka/rdkafkacpp.h>
 
+#include <algorithm>
 #include <atomic>
+#include <charconv>
 #include <chrono>
 #include <csignal>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <mutex>
-#include <random>
+#include <new>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "admission.hpp"
+#include "async_log.hpp"
+#include "cpu_affinity.hpp"
+#include "json_scan.hpp"
+#include "kafka_headers.hpp"
+#include "metrics.hpp"
+#include "partition_ingest.hpp"
+#include "request_id.hpp"
+#include "result_cache.hpp"
+#include "result_waiters.hpp"
+#include "text_result.hpp"
+#include "wire.hpp"
+#include "work_stealing_pool.hpp"
 
 using json = nlohmann::json;
 using namespace Pistache;
@@ -32,31 +51,79 @@ static int64_t now_ms()
     return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
 }
 
-static std::string gen_request_id()
+// Отчёты о доставке в text_requests: метрики и учёт очереди для контроля допуска
+class DeliveryMetrics : public RdKafka::DeliveryReportCb
 {
-    static thread_local std::mt19937_64 rng{std::random_device{}()};
-    std::uniform_int_distribution<uint64_t> dist(0, std::numeric_limits<uint64_t>::max());
+public:
+    DeliveryMetrics(GatewayMetrics &metrics, AdmissionControl &admission) : metrics_(metrics), admission_(admission) {}
 
-    auto to_hex16 = [](uint64_t x)
+    void dr_cb(RdKafka::Message &message) override
     {
-        const char *hex = "0123456789abcdef";
-        std::string s(16, '0');
-        for (int i = 15; i >= 0; --i)
+        admission_.on_delivered(message.len(), message.latency());
+        if (message.err() != RdKafka::ERR_NO_ERROR)
         {
-            s[i] = hex[x & 0xF];
-            x >>= 4;
+            metrics_.delivery_failed.inc();
+            return;
         }
-        return s;
-    };
+        metrics_.delivered.inc();
+        metrics_.delivery.record_us(message.latency());
+    }
+
+private:
+    GatewayMetrics &metrics_;
+    AdmissionControl &admission_;
+};
+
+struct ProducerOptions
+{
+    int linger_ms = 5;
+    int batch_num_messages = 10000;
+    int batch_bytes = 1000000;
+    std::string compression = "none";
+    bool wire_binary = true; // формат запросов, см. wire.hpp
+};
+
+// Чтение text_results: поток на раздел, пачки до batch сообщений, смещения
+// коммитятся librdkafka раз в commit_interval_ms.
+struct ResultConsumerOptions
+{
+    size_t batch = 500;
+    int commit_interval_ms = 1000;
+};
+
+// Параметры Pistache-endpoint. threads == 0 -- по числу ядер (см. http_threads()).
+struct HttpOptions
+{
+    size_t threads = 0;
+    size_t max_request_bytes = 16u << 20; // /check/batch до BATCH_MAX_ITEMS текстов
+    size_t max_response_bytes = 4u << 20;
+    int backlog = 1024;
+    int keepalive_ms = 60000;
+    int header_timeout_ms = 10000;
+    int body_timeout_ms = 60000;
+    bool pin_threads = false; // привязать потоки reactor к ядрам
+};
 
-    // 32 hex chars
-    return to_hex16(dist(rng)) + to_hex16(dist(rng));
+// keepaliveTimeout есть не во всех версиях Pistache (в пакете Ubuntu 22.04 его нет).
+template <typename Opts>
+static auto set_keepalive(Opts &opts, std::chrono::milliseconds t, int) -> decltype(opts.keepaliveTimeout(t), bool())
+{
+    opts.keepaliveTimeout(t);
+    return true;
 }
 
-struct CacheEntry
+template <typename Opts>
+static bool set_keepalive(Opts &, std::chrono::milliseconds, long)
 {
-    json value;
-    int64_t inserted_ms{0};
+    return false;
+}
+
+// PIPELINE_MODE=inprocess: Kafka и worker не нужны -- метрики считаются в пуле
+// gateway, результат сразу попадает в кэш.
+struct PipelineOptions
+{
+    bool inprocess = false;
+    size_t threads = 0; // 0 -- по числу ядер
 };
 
 class GatewayApp
@@ -66,12 +133,47 @@ public:
                std::string req_topic,
                std::string res_topic,
                int port,
-               int ttl_seconds)
+               int ttl_seconds,
+               size_t cache_shards,
+               size_t cache_max_bytes,
+               int max_wait_ms,
+               size_t max_waiters,
+               ProducerOptions producer_opts,
+               ResultConsumerOptions result_opts,
+               size_t max_batch_items,
+               PipelineOptions pipeline_opts,
+               AdmissionOptions admission_opts,
+               HttpOptions http_opts,
+               LogOptions log_opts)
         : brokers_(std::move(brokers)),
           req_topic_(std::move(req_topic)),
           res_topic_(std::move(res_topic)),
           port_(port),
-          ttl_ms_(ttl_seconds * 1000LL) {}
+          ttl_ms_(ttl_seconds * 1000LL),
+          max_wait_ms_(max_wait_ms),
+          producer_opts_(std::move(producer_opts)),
+          result_opts_(result_opts),
+          max_batch_items_(max_batch_items),
+          pipeline_opts_(pipeline_opts),
+          http_opts_(http_opts),
+          log_("gateway", log_opts),
+          cache_(cache_shards, cache_max_bytes),
+          waiters_(max_waiters),
+          admission_(admission_opts),
+          delivery_metrics_(metrics_, admission_) {}
+
+    // Kafka-клиенты или, в режиме inprocess, локальный пул.
+    bool init()
+    {
+        if (!pipeline_opts_.inprocess)
+            return init_kafka();
+        size_t threads = pipeline_opts_.threads;
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        pipeline_ = std::make_unique<WorkStealingPool>(threads);
+        std::cout << "[gateway] in-process pipeline: threads=" << threads << " (Kafka not used)\n";
+        return true;
+    }
 
     bool init_kafka()
     {
@@ -92,7 +194,26 @@ public:
                 return false;
             }
             conf->set("client.id", "gateway", errstr);
-            conf->set("queue.buffering.max.ms", "5", errstr);
+            if (conf->set("dr_cb", &delivery_metrics_, errstr) != RdKafka::Conf::CONF_OK)
+            {
+                std::cerr << "[gateway] producer conf error: " << errstr << "\n";
+                return false;
+            }
+            // пакетирование задаётся явно: /check/batch ставит в очередь сразу много
+            // сообщений, и они должны уходить к брокеру общими пакетами
+            const std::pair<const char *, std::string> tuning[] = {
+                {"linger.ms", std::to_string(producer_opts_.linger_ms)},
+                {"batch.num.messages", std::to_string(producer_opts_.batch_num_messages)},
+                {"batch.size", std::to_string(producer_opts_.batch_bytes)},
+                {"compression.type", producer_opts_.compression}};
+            for (const auto &kv : tuning)
+            {
+                if (conf->set(kv.first, kv.second, errstr) != RdKafka::Conf::CONF_OK)
+                {
+                    std::cerr << "[gateway] producer conf error: " << kv.first << ": " << errstr << "\n";
+                    return false;
+                }
+            }
 
             producer_.reset(RdKafka::Producer::create(conf.get(), errstr));
             if (!producer_)
@@ -117,8 +238,19 @@ public:
                 return false;
             }
             conf->set("group.id", "gateway_results_cache", errstr);
-            conf->set("enable.auto.commit", "false", errstr);
             conf->set("auto.offset.reset", "earliest", errstr);
+            // смещения сохраняют потоки разделов после обработки пачки, коммит -- фоновый
+            conf->set("enable.auto.commit", "true", errstr);
+            conf->set("enable.auto.offset.store", "false", errstr);
+            conf->set("auto.commit.interval.ms", std::to_string(result_opts_.commit_interval_ms), errstr);
+
+            ingest_ = std::make_unique<PartitionIngest>(log_, result_opts_.batch, [this](RdKafka::Message &msg)
+                                                        { ingest_result(msg); });
+            if (conf->set("rebalance_cb", ingest_.get(), errstr) != RdKafka::Conf::CONF_OK)
+            {
+                std::cerr << "[gateway] consumer conf error: " << errstr << "\n";
+                return false;
+            }
 
             consumer_.reset(RdKafka::KafkaConsumer::create(conf.get(), errstr));
             if (!consumer_)
@@ -136,54 +268,100 @@ public:
         }
 
         std::cout << "[gateway] Kafka initialized. brokers=" << brokers_
-                  << " req_topic=" << req_topic_ << " res_topic=" << res_topic_ << "\n";
+                  << " req_topic=" << req_topic_ << " res_topic=" << res_topic_
+                  << " wire=" << (producer_opts_.wire_binary ? "binary" : "json")
+                  << " result_batch=" << result_opts_.batch
+                  << " commit_interval_ms=" << result_opts_.commit_interval_ms << "\n";
         return true;
     }
 
+    // По умолчанию: ядра минус два под librdkafka и потоки результатов,
+    // в режиме inprocess -- половина ядер (остальные считают метрики).
+    size_t http_threads() const
+    {
+        if (http_opts_.threads > 0)
+            return http_opts_.threads;
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        const size_t n = pipeline_opts_.inprocess ? cores / 2 : (cores > 2 ? cores - 2 : 1);
+        return std::max<size_t>(2, n);
+    }
+
     void start_http()
     {
-        Http::Endpoint::Options opts;
-        opts.threads(2);
+        const size_t threads = http_threads();
+        auto opts = Http::Endpoint::options()
+                        .threads(static_cast<int>(threads))
+                        .threadsName(kHttpThreadName)
+                        .flags(Tcp::Options::ReuseAddr | Tcp::Options::NoDelay)
+                        .backlog(http_opts_.backlog)
+                        .maxRequestSize(http_opts_.max_request_bytes)
+                        .maxResponseSize(http_opts_.max_response_bytes)
+                        .headerTimeout(std::chrono::milliseconds(http_opts_.header_timeout_ms))
+                        .bodyTimeout(std::chrono::milliseconds(http_opts_.body_timeout_ms));
+        if (!set_keepalive(opts, std::chrono::milliseconds(http_opts_.keepalive_ms), 0))
+            std::cerr << "[gateway] HTTP_KEEPALIVE_MS ignored: not supported by this Pistache\n";
 
         endpoint_ = std::make_unique<Http::Endpoint>(Address(Ipv4::any(), Port(port_)));
         endpoint_->init(opts);
 
         using namespace Rest;
         Routes::Post(router_, "/check", Routes::bind(&GatewayApp::handle_check, this));
+        Routes::Post(router_, "/check/batch", Routes::bind(&GatewayApp::handle_check_batch, this));
         Routes::Get(router_, "/result/:id", Routes::bind(&GatewayApp::handle_result, this));
         Routes::Get(router_, "/health", Routes::bind(&GatewayApp::handle_health, this));
+        Routes::Get(router_, "/metrics", Routes::bind(&GatewayApp::handle_metrics, this));
 
         endpoint_->setHandler(router_.handler());
         endpoint_->serveThreaded();
 
-        std::cout << "[gateway] HTTP server started on 0.0.0.0:" << port_ << "\n";
+        size_t pinned = 0;
+        if (http_opts_.pin_threads)
+            pinned = pin_threads_by_name(kHttpThreadName, threads, 0);
+
+        std::cout << "[gateway] HTTP server started on 0.0.0.0:" << port_ << " threads=" << threads
+                  << " max_request=" << http_opts_.max_request_bytes << " backlog=" << http_opts_.backlog
+                  << " pinned=" << pinned << "\n";
     }
 
     void start_consumer_thread()
     {
-        consumer_thread_ = std::thread([this]
-                                       { this->consume_results_loop(); });
+        if (pipeline_)
+            consumer_thread_ = std::thread([this]
+                                           { this->expire_loop(); });
+        else
+            consumer_thread_ = std::thread([this]
+                                           { this->consume_results_loop(); });
     }
 
     void stop()
     {
         std::cout << "[gateway] Shutting down...\n";
 
+        // незавершённые long-poll запросы получают "processing" до остановки HTTP
+        waiters_.shutdown();
+
         if (endpoint_)
         {
             endpoint_->shutdown();
         }
 
+        if (consumer_thread_.joinable())
+        {
+            consumer_thread_.join();
+        }
+
         if (consumer_)
         {
+            // отзыв разделов останавливает их потоки, затем коммит сохранённых смещений
             consumer_->close();
         }
-
-        if (consumer_thread_.joinable())
+        if (ingest_)
         {
-            consumer_thread_.join();
+            ingest_->stop_all();
         }
 
+        pipeline_.reset(); // досчитать принятые задачи
+
         if (producer_)
         {
             producer_->flush(5000);
@@ -193,6 +371,7 @@ public:
         producer_.reset();
 
         RdKafka::wait_destroyed(5000);
+        log_.stop(); // дописать очередь до финальной строки
         std::cout << "[gateway] Stopped.\n";
     }
 
@@ -202,97 +381,567 @@ private:
         response.send(Http::Code::Ok, "ok\n");
     }
 
+    void handle_metrics(const Rest::Request &, Http::ResponseWriter response)
+    {
+        response.headers().add<Http::Header::ContentType>(MIME(Text, Plain));
+        GatewayGauges g;
+        g.cache_size = cache_.size();
+        g.cache_bytes = cache_.memory_bytes();
+        g.cache_evictions = cache_.evictions();
+        g.waiters = waiters_.size();
+        g.queue_messages = queued_messages();
+        g.queue_bytes = admission_.inflight_bytes();
+        g.delivery_avg_us = admission_.delivery_avg_us();
+        response.send(Http::Code::Ok, metrics_.render(g));
+    }
+
+    // Сообщения, ещё не подтверждённые Kafka (в inprocess -- задачи пула).
+    size_t queued_messages() const
+    {
+        if (producer_)
+            return static_cast<size_t>(std::max(0, producer_->outq_len()));
+        return pipeline_ ? pipeline_->pending() : 0;
+    }
+
+    // Допуск n текстов до разбора и постановки в очередь; при отказе сразу 429.
+    // bytes -- размер тела запроса: сверху ограничивает объём будущих сообщений.
+    bool admit(Http::ResponseWriter &response, size_t n, size_t bytes)
+    {
+        const auto decision = admission_.admit(n, bytes, queued_messages());
+        if (decision)
+            return true;
+        shed(response, n, decision, json::object());
+        return false;
+    }
+
+    // 429 с Retry-After на n отклонённых текстов; extra дописывается в тело ответа.
+    void shed(Http::ResponseWriter &response, size_t n, AdmissionControl::Decision decision, json extra)
+    {
+        metrics_.check_shed.inc(n);
+        const char *reason = AdmissionControl::reason(decision.verdict);
+        log_.debug("check_shed", {{"reason", reason}, {"items", n}});
+        response.headers().addRaw(Http::Header::Raw("Retry-After", std::to_string(decision.retry_after_s)));
+        extra["error"] = "overloaded";
+        extra["reason"] = reason;
+        extra["retry_after_s"] = decision.retry_after_s;
+        send_json(response, Http::Code::Too_Many_Requests, extra);
+    }
+
+    // Без DOM: тело проверяется сканером, а текст переносится в сообщение Kafka
+    // одним копированием в буфер, которым дальше владеет librdkafka (RK_MSG_FREE):
+    // в бинарном формате -- с раскрытием escape, в JSON -- как есть.
     void handle_check(const Rest::Request &request, Http::ResponseWriter response)
     {
-        try
+        const std::string &body = request.body();
+        if (!admit(response, 1, body.size()))
+            return;
+        Stopwatch parse_timer;
+
+        std::string_view text_raw, lang_raw;
+        bool ok = JsonScanner(body).for_each_member([&](std::string_view key, std::string_view value)
+                                                    {
+                                                        if (key == "text")
+                                                            text_raw = value;
+                                                        else if (key == "language")
+                                                            lang_raw = value; });
+        if (!ok)
+        {
+            log_.warn("check_rejected", {{"reason", "invalid json"}});
+            metrics_.check_rejected.inc();
+            return send_json(response, Http::Code::Bad_Request, json{{"error", "invalid json"}});
+        }
+        if (text_raw.empty() || text_raw.front() != '"')
+        {
+            metrics_.check_rejected.inc();
+            return send_json(response, Http::Code::Bad_Request,
+                             json{{"error", "field 'text' is required and must be string"}});
+        }
+        std::string lang = "ru";
+        if (!lang_raw.empty() && lang_raw.front() == '"')
+        {
+            json_string_value(lang_raw, lang);
+        }
+        if (lang != "ru" && lang != "en")
         {
-            auto body = request.body();
-            auto in = json::parse(body);
+            metrics_.check_rejected.inc();
+            return send_json(response, Http::Code::Bad_Request,
+                             json{{"error", "language must be 'ru' or 'en'"}});
+        }
+        metrics_.check_parse.record_us(parse_timer.elapsed_us());
 
-            if (!in.contains("text") || !in["text"].is_string())
+        const RequestId::Hex id = RequestId::generate().hex();
+        const std::string_view request_id = id.view();
+        if (pipeline_)
+        {
+            std::string text;
+            json_string_value(text_raw, text);
+            submit_local(id.str(), std::move(text), lang);
+        }
+        else
+        {
+            size_t len = 0;
+            char *payload = producer_opts_.wire_binary
+                                ? build_binary_payload(request_id, text_raw.substr(1, text_raw.size() - 2), lang, len)
+                                : build_payload(request_id, text_raw, lang, len);
+            auto err = produce_payload(request_id, payload, len, RdKafka::Producer::RK_MSG_FREE);
+            if (err != RdKafka::ERR_NO_ERROR)
             {
-                return send_json(response, Http::Code::Bad_Request,
-                                 json{{"error", "field 'text' is required and must be string"}});
+                std::free(payload); // при ошибке буфер остаётся за нами
+            }
+            producer_->poll(0);
+
+            if (err == RdKafka::ERR__QUEUE_FULL)
+                return shed(response, 1, admission_.producer_queue_full(), json::object());
+            if (err != RdKafka::ERR_NO_ERROR)
+            {
+                log_.error("produce_failed", {{"request_id", request_id}, {"error", RdKafka::err2str(err)}});
+                return send_json(response, Http::Code::Service_Unavailable,
+                                 json{{"error", "kafka produce failed"}, {"details", RdKafka::err2str(err)}});
             }
-            std::string text = in["text"].get<std::string>();
-            std::string lang = "ru";
-            if (in.contains("language") && in["language"].is_string())
+        }
+        metrics_.check_requests.inc();
+
+        log_.info("accepted", {{"request_id", request_id}, {"bytes", text_raw.size() - 2}, {"lang", lang}});
+
+        std::string out;
+        out.reserve(RequestId::kHexLen + 18);
+        out.append("{\"request_id\":\"").append(request_id).append("\"}");
+        return send_raw_json(response, Http::Code::Ok, out);
+    }
+
+    // {"request_id":"..","timestamp":N,"language":"..","text":<text_json>} в буфере malloc.
+    // text_json -- уже проверенная JSON-строка вместе с кавычками.
+    static char *build_payload(std::string_view request_id, std::string_view text_json,
+                               const std::string &lang, size_t &len)
+    {
+        char head[160];
+        int head_len = std::snprintf(head, sizeof(head),
+                                     "{\"request_id\":\"%.*s\",\"timestamp\":%lld,\"language\":\"%s\",\"text\":",
+                                     static_cast<int>(request_id.size()), request_id.data(),
+                                     static_cast<long long>(now_ms()), lang.c_str());
+        len = static_cast<size_t>(head_len) + text_json.size() + 1;
+        char *buf = static_cast<char *>(std::malloc(len));
+        if (!buf)
+            throw std::bad_alloc();
+        std::memcpy(buf, head, static_cast<size_t>(head_len));
+        std::memcpy(buf + head_len, text_json.data(), text_json.size());
+        buf[len - 1] = '}';
+        return buf;
+    }
+
+    // Бинарный запрос (wire.hpp) в буфере malloc. text_body -- содержимое проверенной
+    // JSON-строки без кавычек: раскрытый текст не длиннее, поэтому пишется сразу на место.
+    static char *build_binary_payload(std::string_view request_id, std::string_view text_body,
+                                      const std::string &lang, size_t &len)
+    {
+        const size_t head_len = wire::request_header_size(request_id, lang);
+        char *buf = static_cast<char *>(std::malloc(head_len + text_body.size()));
+        if (!buf)
+            throw std::bad_alloc();
+        size_t text_len = text_body.size();
+        if (text_body.find('\\') == std::string_view::npos)
+            std::memcpy(buf + head_len, text_body.data(), text_len);
+        else
+            text_len = json_unescape_to(text_body, buf + head_len);
+        wire::write_request_header(buf, request_id, now_ms(), lang, static_cast<uint32_t>(text_len));
+        len = head_len + text_len;
+        return buf;
+    }
+
+    // Тело: [{text, language}, ...] или {"items": [...]}.
+    // Все элементы проверяются до отправки: при ошибке в любом ничего не публикуется.
+    // Сообщения ставятся в очередь producer подряд, одним проходом, и librdkafka
+    // собирает их в общие пакеты (см. KAFKA_LINGER_MS / KAFKA_BATCH_*). На первом
+    // QUEUE_FULL остаток пачки не публикуется: ответ 429 с id уже принятых элементов.
+    void handle_check_batch(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        try
+        {
+            auto in = json::parse(request.body());
+            const json *items = &in;
+            if (in.is_object() && in.contains("items"))
+                items = &in["items"];
+            if (!items->is_array() || items->empty())
             {
-                lang = in["language"].get<std::string>();
+                metrics_.check_rejected.inc();
+                return send_json(response, Http::Code::Bad_Request,
+                                 json{{"error", "body must be a non-empty array of {text, language}"}});
             }
-            if (lang != "ru" && lang != "en")
+            if (items->size() > max_batch_items_)
             {
+                metrics_.check_rejected.inc();
                 return send_json(response, Http::Code::Bad_Request,
-                                 json{{"error", "language must be 'ru' or 'en'"}});
+                                 json{{"error", "too many items"}, {"max_items", max_batch_items_}});
             }
+            if (!admit(response, items->size(), request.body().size()))
+                return;
 
-            std::string request_id = gen_request_id();
-            json msg = {
-                {"request_id", request_id},
-                {"timestamp", now_ms()},
-                {"text", text},
-                {"language", lang}};
-
-            std::string payload = msg.dump();
-            auto err = producer_->produce(
-                req_topic_,
-                RdKafka::Topic::PARTITION_UA,
-                RdKafka::Producer::RK_MSG_COPY,
-                const_cast<char *>(payload.data()),
-                payload.size(),
-                &request_id,
-                nullptr);
-
-            producer_->poll(0);
+            std::vector<std::string> texts(items->size()), langs(items->size());
+            for (size_t i = 0; i < items->size(); ++i)
+            {
+                std::string error = parse_item((*items)[i], texts[i], langs[i]);
+                if (!error.empty())
+                {
+                    metrics_.check_rejected.inc();
+                    return send_json(response, Http::Code::Bad_Request, json{{"error", error}, {"index", i}});
+                }
+            }
 
-            if (err != RdKafka::ERR_NO_ERROR)
+            json ids = json::array();
+            size_t failed = 0;
+            size_t shed_items = 0; // начиная с первого QUEUE_FULL
+            size_t bytes = 0;
+            RdKafka::ErrorCode last_err = RdKafka::ERR_NO_ERROR;
+            for (size_t i = 0; i < texts.size(); ++i)
             {
-                std::cerr << "[gateway] produce error: " << RdKafka::err2str(err) << "\n";
-                return send_json(response, Http::Code::Service_Unavailable,
-                                 json{{"error", "kafka produce failed"}, {"details", RdKafka::err2str(err)}});
+                if (last_err == RdKafka::ERR__QUEUE_FULL)
+                {
+                    // очередь librdkafka полна: остаток пачки не ставим и не ждём
+                    ids.push_back(nullptr);
+                    failed++;
+                    shed_items++;
+                    continue;
+                }
+                std::string request_id = RequestId::generate().str();
+                if (pipeline_)
+                {
+                    bytes += texts[i].size();
+                    submit_local(request_id, std::move(texts[i]), langs[i]);
+                    ids.push_back(std::move(request_id));
+                    continue;
+                }
+                auto err = produce_request(request_id, texts[i], langs[i]);
+                if (err == RdKafka::ERR_NO_ERROR)
+                {
+                    ids.push_back(std::move(request_id));
+                    bytes += texts[i].size();
+                }
+                else
+                {
+                    ids.push_back(nullptr);
+                    failed++;
+                    shed_items += err == RdKafka::ERR__QUEUE_FULL;
+                    last_err = err;
+                }
             }
+            if (producer_)
+                producer_->poll(0);
+            metrics_.check_requests.inc(texts.size() - failed);
 
-            std::cout << "[gateway] accepted request_id=" << request_id
-                      << " bytes=" << text.size() << " lang=" << lang << "\n";
+            log_.info("accepted_batch", {{"items", texts.size() - failed}, {"failed", failed}, {"bytes", bytes}});
 
-            return send_json(response, Http::Code::Ok, json{{"request_id", request_id}});
+            if (last_err == RdKafka::ERR__QUEUE_FULL)
+                return shed(response, shed_items, admission_.producer_queue_full(),
+                            json{{"failed", failed}, {"request_ids", std::move(ids)}});
+            if (failed > 0)
+            {
+                log_.error("produce_failed", {{"failed", failed}, {"error", RdKafka::err2str(last_err)}});
+                return send_json(response, Http::Code::Service_Unavailable,
+                                 json{{"error", "kafka produce failed"},
+                                      {"details", RdKafka::err2str(last_err)},
+                                      {"failed", failed},
+                                      {"request_ids", std::move(ids)}});
+            }
+            return send_json(response, Http::Code::Ok, json{{"request_ids", std::move(ids)}});
         }
         catch (const std::exception &e)
         {
-            std::cerr << "[gateway] /check error: " << e.what() << "\n";
+            log_.warn("check_rejected", {{"reason", "invalid json"}, {"details", e.what()}});
+            metrics_.check_rejected.inc();
             return send_json(response, Http::Code::Bad_Request,
                              json{{"error", "invalid json"}, {"details", e.what()}});
         }
     }
 
+    // Разбирает элемент {text, language}. Пустая строка -- ошибок нет.
+    static std::string parse_item(const json &in, std::string &text, std::string &lang)
+    {
+        if (!in.is_object() || !in.contains("text") || !in["text"].is_string())
+            return "field 'text' is required and must be string";
+        text = in["text"].get<std::string>();
+        lang = "ru";
+        if (in.contains("language") && in["language"].is_string())
+            lang = in["language"].get<std::string>();
+        if (lang != "ru" && lang != "en")
+            return "language must be 'ru' or 'en'";
+        return {};
+    }
+
+    // Задание из DOM (путь /check/batch): сериализация и копирование librdkafka.
+    RdKafka::ErrorCode produce_request(const std::string &request_id, const std::string &text, const std::string &lang)
+    {
+        if (producer_opts_.wire_binary)
+        {
+            std::string payload;
+            wire::encode_request(wire::Request{request_id, now_ms(), lang, text}, payload);
+            return produce_payload(request_id, payload.data(), payload.size(), RdKafka::Producer::RK_MSG_COPY);
+        }
+        json msg = {
+            {"request_id", request_id},
+            {"timestamp", now_ms()},
+            {"text", text},
+            {"language", lang}};
+        std::string payload = msg.dump();
+        return produce_payload(request_id, payload.data(), payload.size(), RdKafka::Producer::RK_MSG_COPY);
+    }
+
+    // Ставит сообщение в очередь producer (ключ -- request_id). QUEUE_FULL не ждём:
+    // HTTP-поток не блокируется, вызывающий сразу отвечает 429.
+    // С RK_MSG_FREE буфер переходит к librdkafka только при успехе (как и заголовки).
+    RdKafka::ErrorCode produce_payload(std::string_view request_id, char *payload, size_t len, int msgflags)
+    {
+        RdKafka::Headers *headers = nullptr;
+        if (producer_opts_.wire_binary)
+        {
+            // бинарный запрос; результат тоже принимаем бинарным
+            headers = RdKafka::Headers::create();
+            headers->add(wire::kHeaderFormat, wire::kBinaryV1.data(), wire::kBinaryV1.size());
+            headers->add(wire::kHeaderAccept, wire::kBinaryV1.data(), wire::kBinaryV1.size());
+        }
+        Stopwatch produce_timer;
+        RdKafka::ErrorCode err = producer_->produce(
+            req_topic_,
+            RdKafka::Topic::PARTITION_UA,
+            msgflags,
+            payload,
+            len,
+            request_id.data(),
+            request_id.size(),
+            0,
+            headers,
+            nullptr);
+        metrics_.produce_call.record_us(produce_timer.elapsed_us());
+        if (err != RdKafka::ERR_NO_ERROR)
+        {
+            delete headers;
+            metrics_.produce_errors.inc();
+        }
+        else
+        {
+            admission_.on_enqueued(len);
+        }
+        return err;
+    }
+
     void handle_result(const Rest::Request &request, Http::ResponseWriter response)
     {
         auto id = request.param(":id").as<std::string>();
 
+        thread_local std::string body; // буфер HTTP-потока, ёмкость переживает запросы
+        if (cache_.copy_to(id, body))
         {
-            std::lock_guard<std::mutex> lk(cache_mtx_);
-            auto it = cache_.find(id);
-            if (it != cache_.end())
+            metrics_.cache_hits.inc();
+            return send_raw_json(response, Http::Code::Ok, body);
+        }
+        metrics_.cache_misses.inc();
+
+        // ?wait_ms=N -- long-poll: ответ откладывается до появления результата или таймаута
+        int64_t wait_ms = 0;
+        if (auto v = request.query().get("wait_ms"))
+        {
+            try
+            {
+                wait_ms = std::stoll(*v);
+            }
+            catch (...)
             {
-                return send_json(response, Http::Code::Ok, it->second.value);
+                return send_json(response, Http::Code::Bad_Request,
+                                 json{{"error", "wait_ms must be an integer"}});
             }
         }
-        return send_json(response, Http::Code::Ok, json{{"request_id", id}, {"status", "processing"}});
+        wait_ms = std::min<int64_t>(wait_ms, max_wait_ms_);
+        if (wait_ms > 0)
+        {
+            // ResponseWriter переезжает в колбэк; ответ отправит consumer или поток таймеров
+            auto writer = std::make_shared<Http::ResponseWriter>(std::move(response));
+            bool parked = waiters_.wait(
+                id, now_ms() + wait_ms,
+                [&]
+                { return cache_.get(id); },
+                [writer, id](ResultWaiters::Body body)
+                {
+                    if (body)
+                        send_raw_json(*writer, Http::Code::Ok, *body);
+                    else
+                        send_processing(*writer, id);
+                });
+            if (parked)
+                return;
+            response = std::move(*writer); // лимит ожиданий: отвечаем сразу
+        }
+        send_processing(response, id);
+    }
+
+    static void send_processing(Http::ResponseWriter &response, const std::string &id)
+    {
+        send_json(response, Http::Code::Ok, json{{"request_id", id}, {"status", "processing"}});
     }
 
     static void send_json(Http::ResponseWriter &response, Http::Code code, const json &j)
+    {
+        send_raw_json(response, code, j.dump());
+    }
+
+    // body -- уже сериализованный JSON (например, результат из кэша)
+    static void send_raw_json(Http::ResponseWriter &response, Http::Code code, const std::string &body)
     {
         response.headers().add<Http::Header::ContentType>(MIME(Application, Json));
-        response.send(code, j.dump());
+        response.send(code, body);
+    }
+
+    // Сырое JSON-значение для лога: строки без кавычек, отсутствующее -- n/a
+    static std::string_view unquote(std::string_view raw)
+    {
+        if (raw.empty())
+            return "n/a";
+        if (raw.size() >= 2 && raw.front() == '"')
+            return raw.substr(1, raw.size() - 2);
+        return raw;
+    }
+
+    // Режим inprocess: то же, что делает worker (compute_metrics + compute_score),
+    // но в пуле gateway; JSON результата -- тот же, что gateway собрал бы из бинарного ответа.
+    void submit_local(const std::string &request_id, std::string text, std::string lang)
+    {
+        const int64_t ts = now_ms();
+        pipeline_->submit([this, id = request_id, text = std::move(text), lang = std::move(lang), ts, timer = Stopwatch()]
+                          {
+                              TextMetrics m = compute_metrics(text.data(), text.size(), lang);
+                              std::vector<std::string> errors;
+                              const int score = compute_score(m, lang, errors);
+                              const std::string status = status_from_score(score, errors);
+
+                              wire::Result r;
+                              r.request_id = id;
+                              r.timestamp = ts;
+                              r.processed_ms = now_ms();
+                              r.language = lang;
+                              r.score = score;
+                              r.status = status;
+                              r.errors.assign(errors.begin(), errors.end());
+                              r.has_metrics = true;
+                              r.metrics = metrics_to_wire(m);
+                              std::string json_body;
+                              wire::result_to_json(r, json_body);
+
+                              auto body = std::make_shared<const std::string>(std::move(json_body));
+                              cache_.put(id, *body, now_ms());
+                              waiters_.resolve(id, body); // строго после put, см. ResultWaiters::wait
+                              metrics_.results_consumed.inc();
+                              metrics_.end_to_end.record_us(timer.elapsed_us());
+                              log_.info("result_cached", {{"request_id", id}, {"score", score}, {"status", status}}); });
+    }
+
+    // Разобранное сообщение text_results: тело для кэша (JSON) и поля для метрик и лога.
+    struct CachedResult
+    {
+        const char *error = nullptr; // причина отказа; nullptr -- сообщение годное
+        std::string id;
+        std::shared_ptr<const std::string> body;
+        int64_t request_ts = 0;
+        std::string score;
+        std::string status;
+    };
+
+    // JSON: DOM не строим -- проверяем структуру и достаём поля, а в кэш кладём
+    // байты сообщения как есть
+    static CachedResult parse_json_result(const char *data, size_t len)
+    {
+        CachedResult res;
+        std::string_view id_raw, score_raw, status_raw, ts_raw;
+        bool ok = JsonScanner(data, len).for_each_member([&](std::string_view key, std::string_view value)
+                                                         {
+                                                             if (key == "request_id")
+                                                                 id_raw = value;
+                                                             else if (key == "score")
+                                                                 score_raw = value;
+                                                             else if (key == "status")
+                                                                 status_raw = value;
+                                                             else if (key == "timestamp")
+                                                                 ts_raw = value; });
+        if (!ok)
+        {
+            res.error = "malformed json";
+            return res;
+        }
+        if (!json_string_value(id_raw, res.id))
+        {
+            res.error = "no request_id";
+            return res;
+        }
+        res.body = std::make_shared<const std::string>(data, len);
+        std::from_chars(ts_raw.data(), ts_raw.data() + ts_raw.size(), res.request_ts);
+        res.score = unquote(score_raw);
+        res.status = unquote(status_raw);
+        return res;
+    }
+
+    // Бинарный результат: клиенту отдаётся тот же JSON, что сформировал бы worker
+    static CachedResult parse_binary_result(const char *data, size_t len)
+    {
+        CachedResult res;
+        wire::Result r;
+        if (!wire::decode_result(data, len, r))
+        {
+            res.error = "malformed binary";
+            return res;
+        }
+        if (r.request_id.empty())
+        {
+            res.error = "no request_id";
+            return res;
+        }
+        std::string body;
+        wire::result_to_json(r, body);
+        res.id.assign(r.request_id.data(), r.request_id.size());
+        res.body = std::make_shared<const std::string>(std::move(body));
+        res.request_ts = r.timestamp;
+        res.score = std::to_string(r.score);
+        res.status.assign(r.status.data(), r.status.size());
+        return res;
     }
 
+    // Результат из text_results -> кэш и ожидающие long-poll. Вызывается из потоков разделов.
+    void ingest_result(RdKafka::Message &msg)
+    {
+        Stopwatch consume_timer;
+        CachedResult res;
+        if (kafka_header_is(msg.headers(), wire::kHeaderFormat, wire::kBinaryV1))
+            res = parse_binary_result(static_cast<const char *>(msg.payload()), msg.len());
+        else
+            res = parse_json_result(static_cast<const char *>(msg.payload()), msg.len());
+
+        if (!res.error)
+        {
+            if (!cache_.put(res.id, *res.body, now_ms()))
+                log_.warn("result_not_cached", {{"request_id", res.id}, {"bytes", res.body->size()}});
+            waiters_.resolve(res.id, res.body); // строго после put, см. ResultWaiters::wait
+            metrics_.results_consumed.inc();
+            metrics_.consume_to_cache.record_us(consume_timer.elapsed_us());
+            // timestamp результата -- время приёма запроса gateway (мс)
+            if (res.request_ts > 0)
+                metrics_.end_to_end.record_us((now_ms() - res.request_ts) * 1000);
+            log_.info("result_cached", {{"request_id", res.id}, {"score", res.score}, {"status", res.status}});
+        }
+        else
+        {
+            log_.warn("result_rejected", {{"reason", res.error}});
+            metrics_.results_malformed.inc();
+        }
+    }
+
+    // Сообщения читают потоки разделов; здесь -- колбэки ребалансировки, ошибки,
+    // отчёты о доставке запросов и TTL кэша.
     void consume_results_loop()
     {
         std::cout << "[gateway] results consumer thread started\n";
-        int64_t last_cleanup = now_ms();
+        int64_t last_expire = now_ms();
 
         while (!g_stop.load())
         {
+            // отчёты о доставке запросов обслуживаются и без входящего HTTP-трафика
+            producer_->poll(0);
+
             std::unique_ptr<RdKafka::Message> msg(consumer_->consume(200));
             if (!msg)
                 continue;
@@ -303,35 +952,8 @@ private:
             }
             else if (msg->err() == RdKafka::ERR_NO_ERROR)
             {
-                try
-                {
-                    std::string payload(static_cast<const char *>(msg->payload()), msg->len());
-                    auto j = json::parse(payload);
-
-                    if (j.contains("request_id") && j["request_id"].is_string())
-                    {
-                        std::string id = j["request_id"].get<std::string>();
-                        {
-                            std::lock_guard<std::mutex> lk(cache_mtx_);
-                            cache_[id] = CacheEntry{j, now_ms()};
-                        }
-                        consumer_->commitSync(msg.get());
-                        std::cout << "[gateway] cached result request_id=" << id
-                                  << " score=" << (j.contains("score") ? j["score"].dump() : "n/a")
-                                  << " status=" << (j.contains("status") ? j["status"].dump() : "n/a")
-                                  << "\n";
-                    }
-                    else
-                    {
-                        std::cerr << "[gateway] invalid result message (no request_id)\n";
-                        consumer_->commitSync(msg.get());
-                    }
-                }
-                catch (const std::exception &e)
-                {
-                    std::cerr << "[gateway] parse result error: " << e.what() << "\n";
-                    consumer_->commitSync(msg.get()); // чтобы не застрять на битом сообщении
-                }
+                // раздел ещё не отцеплен от общей очереди (см. PartitionIngest)
+                ingest_->handle_and_store(consumer_.get(), *msg);
             }
             else if (msg->err() == RdKafka::ERR__PARTITION_EOF)
             {
@@ -339,44 +961,71 @@ private:
             }
             else
             {
-                std::cerr << "[gateway] consumer error: " << msg->errstr() << "\n";
+                log_.error("consume_failed", {{"error", msg->errstr()}});
             }
 
-            // Cleanup TTL
-            int64_t t = now_ms();
-            if (t - last_cleanup >= 5000)
-            {
-                last_cleanup = t;
-                std::lock_guard<std::mutex> lk(cache_mtx_);
-                for (auto it = cache_.begin(); it != cache_.end();)
-                {
-                    if (t - it->second.inserted_ms > ttl_ms_)
-                        it = cache_.erase(it);
-                    else
-                        ++it;
-                }
-            }
+            expire_tick(last_expire);
         }
 
         std::cout << "[gateway] results consumer thread exiting\n";
     }
 
+    // TTL: частые короткие тики снимают только просроченные записи
+    void expire_tick(int64_t &last_expire)
+    {
+        int64_t t = now_ms();
+        if (t - last_expire >= kExpireTickMs)
+        {
+            last_expire = t;
+            metrics_.ttl_evictions.inc(cache_.expire(t, ttl_ms_, kExpireBudget));
+        }
+    }
+
+    // Режим inprocess: результатов из Kafka нет, поток только чистит кэш по TTL.
+    void expire_loop()
+    {
+        int64_t last_expire = now_ms();
+        while (!g_stop.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kExpireTickMs));
+            expire_tick(last_expire);
+        }
+    }
+
 private:
+    static constexpr int64_t kExpireTickMs = 100;
+    static constexpr size_t kExpireBudget = 20000; // записей за тик
+    static constexpr const char *kHttpThreadName = "gw-http"; // по нему находятся потоки для привязки
+
     std::string brokers_;
     std::string req_topic_;
     std::string res_topic_;
     int port_;
     int64_t ttl_ms_;
+    int64_t max_wait_ms_;
+    ProducerOptions producer_opts_;
+    ResultConsumerOptions result_opts_;
+    size_t max_batch_items_;
+    PipelineOptions pipeline_opts_;
+    HttpOptions http_opts_;
+
+    // общее состояние объявлено раньше Kafka-клиентов и разрушается после них:
+    // в него пишут колбэки librdkafka и потоки PartitionIngest
+    AsyncLogger log_;
+    GatewayMetrics metrics_;
+    ResultCache cache_;
+    ResultWaiters waiters_;
+    AdmissionControl admission_;
+    DeliveryMetrics delivery_metrics_;
 
     std::unique_ptr<RdKafka::Producer> producer_;
+    std::unique_ptr<PartitionIngest> ingest_; // rebalance_cb: живёт дольше consumer_
     std::unique_ptr<RdKafka::KafkaConsumer> consumer_;
 
-    std::unordered_map<std::string, CacheEntry> cache_;
-    std::mutex cache_mtx_;
-
     Rest::Router router_;
     std::unique_ptr<Http::Endpoint> endpoint_;
     std::thread consumer_thread_;
+    std::unique_ptr<WorkStealingPool> pipeline_; // только в режиме inprocess
 };
 
 static std::string getenv_or(const char *k, const std::string &defv)
@@ -410,10 +1059,64 @@ int main()
     std::string res_topic = getenv_or("KAFKA_RESULT_TOPIC", "text_results");
     int port = getenv_int_or("HTTP_PORT", 8080);
     int ttl = getenv_int_or("RESULT_TTL_SECONDS", 600);
-
-    GatewayApp app(brokers, req_topic, res_topic, port, ttl);
-
-    if (!app.init_kafka())
+    int cache_shards = getenv_int_or("RESULT_CACHE_SHARDS", 64);
+    int cache_max_mb = getenv_int_or("RESULT_CACHE_MAX_MB", 512);
+    int max_wait_ms = getenv_int_or("RESULT_MAX_WAIT_MS", 30000);
+    int max_waiters = getenv_int_or("RESULT_MAX_WAITERS", 100000);
+    int max_batch_items = getenv_int_or("BATCH_MAX_ITEMS", 10000);
+
+    LogOptions log_opts;
+    log_opts.level = parse_log_level(getenv_or("LOG_LEVEL", "info"), LogLevel::Info);
+    log_opts.sample_every = static_cast<unsigned>(std::max(1, getenv_int_or("LOG_SAMPLE", 1)));
+    log_opts.ring_slots = static_cast<size_t>(std::max(2, getenv_int_or("LOG_RING_SLOTS", 8192)));
+
+    ProducerOptions producer_opts;
+    producer_opts.linger_ms = getenv_int_or("KAFKA_LINGER_MS", producer_opts.linger_ms);
+    producer_opts.batch_num_messages = getenv_int_or("KAFKA_BATCH_NUM_MESSAGES", producer_opts.batch_num_messages);
+    producer_opts.batch_bytes = getenv_int_or("KAFKA_BATCH_BYTES", producer_opts.batch_bytes);
+    producer_opts.compression = getenv_or("KAFKA_COMPRESSION", producer_opts.compression);
+    producer_opts.wire_binary = getenv_or("KAFKA_WIRE_FORMAT", "binary") != "json";
+
+    ResultConsumerOptions result_opts;
+    result_opts.batch = static_cast<size_t>(std::max(1, getenv_int_or("RESULT_CONSUME_BATCH", static_cast<int>(result_opts.batch))));
+    result_opts.commit_interval_ms = std::max(10, getenv_int_or("RESULT_COMMIT_INTERVAL_MS", result_opts.commit_interval_ms));
+
+    PipelineOptions pipeline_opts;
+    pipeline_opts.inprocess = getenv_or("PIPELINE_MODE", "kafka") == "inprocess";
+    pipeline_opts.threads = static_cast<size_t>(std::max(0, getenv_int_or("PIPELINE_THREADS", 0)));
+
+    AdmissionOptions admission_opts;
+    admission_opts.rate = std::max(0, getenv_int_or("ADMISSION_RATE", 0));
+    admission_opts.burst = std::max(1, getenv_int_or("ADMISSION_BURST", static_cast<int>(admission_opts.burst)));
+    admission_opts.max_queue_messages = static_cast<size_t>(std::max(0, getenv_int_or("ADMISSION_MAX_QUEUE_MESSAGES", static_cast<int>(admission_opts.max_queue_messages))));
+    admission_opts.max_queue_bytes = static_cast<size_t>(std::max(0, getenv_int_or("ADMISSION_MAX_QUEUE_BYTES", static_cast<int>(admission_opts.max_queue_bytes))));
+    admission_opts.max_delivery_ms = std::max(0, getenv_int_or("ADMISSION_MAX_DELIVERY_MS", static_cast<int>(admission_opts.max_delivery_ms)));
+    admission_opts.retry_after_s = std::max(1, getenv_int_or("ADMISSION_RETRY_AFTER_S", admission_opts.retry_after_s));
+
+    HttpOptions http_opts;
+    http_opts.threads = static_cast<size_t>(std::max(0, getenv_int_or("HTTP_THREADS", 0)));
+    http_opts.max_request_bytes = static_cast<size_t>(std::max(4096, getenv_int_or("HTTP_MAX_REQUEST_BYTES", static_cast<int>(http_opts.max_request_bytes))));
+    http_opts.max_response_bytes = static_cast<size_t>(std::max(4096, getenv_int_or("HTTP_MAX_RESPONSE_BYTES", static_cast<int>(http_opts.max_response_bytes))));
+    http_opts.backlog = std::max(1, getenv_int_or("HTTP_BACKLOG", http_opts.backlog));
+    http_opts.keepalive_ms = std::max(1, getenv_int_or("HTTP_KEEPALIVE_MS", http_opts.keepalive_ms));
+    http_opts.header_timeout_ms = std::max(1, getenv_int_or("HTTP_HEADER_TIMEOUT_MS", http_opts.header_timeout_ms));
+    http_opts.body_timeout_ms = std::max(1, getenv_int_or("HTTP_BODY_TIMEOUT_MS", http_opts.body_timeout_ms));
+    http_opts.pin_threads = getenv_int_or("HTTP_PIN_THREADS", 0) != 0;
+
+    GatewayApp app(brokers, req_topic, res_topic, port, ttl,
+                   static_cast<size_t>(std::max(1, cache_shards)),
+                   static_cast<size_t>(std::max(1, cache_max_mb)) << 20,
+                   std::max(0, max_wait_ms),
+                   static_cast<size_t>(std::max(0, max_waiters)),
+                   producer_opts,
+                   result_opts,
+                   static_cast<size_t>(std::max(1, max_batch_items)),
+                   pipeline_opts,
+                   admission_opts,
+                   http_opts,
+                   log_opts);
+
+    if (!app.init())
     {
         std::cerr << "[gateway] init failed\n";
         return 1;
@@ -0,0 +1,223 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Метрики gateway в текстовом формате Prometheus.
+// Запись -- одна-две relaxed атомарные операции без локов и аллокаций;
+// вся работа по агрегации делается при чтении /metrics.
+
+class Counter
+{
+public:
+    void inc(uint64_t n = 1) { v_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return v_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> v_{0};
+};
+
+// Гистограмма задержек в микросекундах с лог-линейными корзинами (как в HdrHistogram):
+// значения < 2^kSubBits хранятся точно, дальше каждая октава делится на 2^kSubBits
+// равных корзин, т.е. относительная погрешность не больше 1/2^kSubBits (12.5%).
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned kSubBits = 3;
+    static constexpr unsigned kSub = 1u << kSubBits;
+    static constexpr unsigned kMaxExp = 40; // ~12.7 суток в мкс, дальше -- последняя корзина
+    static constexpr size_t kBuckets = kSub + (kMaxExp - kSubBits + 1) * kSub;
+
+    void record_us(int64_t us)
+    {
+        uint64_t v = us > 0 ? static_cast<uint64_t>(us) : 0;
+        buckets_[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    // Пишет histogram (фиксированный набор le в секундах) и квантили отдельной метрикой.
+    void write(std::string &out, const char *name, const char *help) const
+    {
+        uint64_t counts[kBuckets];
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBuckets; ++i)
+        {
+            counts[i] = buckets_[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        const double sum_s = double(sum_us_.load(std::memory_order_relaxed)) / 1e6;
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+        out += line;
+        // корзина попадает в le, если её верхняя граница не больше le
+        size_t b = 0;
+        uint64_t cum = 0;
+        for (double le : kLeSeconds)
+        {
+            const uint64_t le_us = static_cast<uint64_t>(le * 1e6);
+            while (b < kBuckets && upper_of(b) <= le_us)
+                cum += counts[b++];
+            std::snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %llu\n", name, le,
+                          static_cast<unsigned long long>(cum));
+            out += line;
+        }
+        std::snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.6f\n%s_count %llu\n",
+                      name, static_cast<unsigned long long>(total), name, sum_s, name,
+                      static_cast<unsigned long long>(total));
+        out += line;
+
+        std::snprintf(line, sizeof(line), "# TYPE %s_quantile gauge\n", name);
+        out += line;
+        for (double q : {0.5, 0.9, 0.99, 0.999})
+        {
+            std::snprintf(line, sizeof(line), "%s_quantile{quantile=\"%g\"} %.6f\n", name, q,
+                          double(quantile_us(counts, total, q)) / 1e6);
+            out += line;
+        }
+    }
+
+private:
+    static constexpr double kLeSeconds[] = {0.00001, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+                                            0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+
+    static size_t bucket_of(uint64_t v)
+    {
+        if (v < kSub)
+            return static_cast<size_t>(v);
+        unsigned exp = 63u - static_cast<unsigned>(__builtin_clzll(v)); // >= kSubBits
+        if (exp > kMaxExp)
+            return kBuckets - 1;
+        unsigned sub = static_cast<unsigned>(v >> (exp - kSubBits)) & (kSub - 1);
+        return kSub + (exp - kSubBits) * kSub + sub;
+    }
+
+    // Наибольшее значение, попадающее в корзину b.
+    static uint64_t upper_of(size_t b)
+    {
+        if (b < kSub)
+            return b;
+        const unsigned exp = static_cast<unsigned>((b - kSub) / kSub) + kSubBits;
+        const uint64_t sub = (b - kSub) % kSub;
+        const uint64_t step = uint64_t{1} << (exp - kSubBits);
+        return (uint64_t{1} << exp) + (sub + 1) * step - 1;
+    }
+
+    static uint64_t quantile_us(const uint64_t *counts, uint64_t total, double q)
+    {
+        if (total == 0)
+            return 0;
+        const uint64_t rank = static_cast<uint64_t>(q * double(total - 1)) + 1;
+        uint64_t cum = 0;
+        for (size_t b = 0; b < kBuckets; ++b)
+        {
+            cum += counts[b];
+            if (cum >= rank)
+                return upper_of(b);
+        }
+        return upper_of(kBuckets - 1);
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> sum_us_{0};
+};
+
+// Замер интервала по монотонным часам.
+class Stopwatch
+{
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+    int64_t elapsed_us() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Значения, которые принадлежат другим объектам и снимаются при запросе /metrics.
+struct GatewayGauges
+{
+    size_t cache_size = 0;
+    size_t cache_bytes = 0;
+    uint64_t cache_evictions = 0; // счётчик, но ведёт его сам кэш
+    size_t waiters = 0;
+    size_t queue_messages = 0;
+    size_t queue_bytes = 0;
+    int64_t delivery_avg_us = 0;
+};
+
+struct GatewayMetrics
+{
+    Counter check_requests;    // принятые POST /check и элементы /check/batch
+    Counter check_rejected;    // 400 на /check и /check/batch
+    Counter check_shed;        // тексты, отклонённые контролем допуска (429)
+    Counter produce_errors;    // produce() вернул ошибку
+    Counter delivered;         // подтверждённые доставки
+    Counter delivery_failed;   // доставка завершилась ошибкой
+    Counter results_consumed;  // результаты, положенные в кэш
+    Counter results_malformed; // битые сообщения в text_results
+    Counter cache_hits;        // GET /result: результат найден сразу
+    Counter cache_misses;      // GET /result: "processing" или long-poll
+    Counter ttl_evictions;     // удалено по TTL
+
+    LatencyHistogram check_parse;      // разбор и проверка тела /check
+    LatencyHistogram produce_call;     // время внутри producer_->produce
+    LatencyHistogram delivery;         // produce -> delivery report (msg.latency())
+    LatencyHistogram consume_to_cache; // consume() вернул сообщение -> запись в кэше
+    LatencyHistogram end_to_end;       // timestamp запроса -> результат в кэше
+
+    std::string render(const GatewayGauges &g) const
+    {
+        std::string out;
+        out.reserve(16 << 10);
+        char line[256];
+        auto counter_value = [&](const char *name, const char *help, uint64_t v)
+        {
+            std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                          name, help, name, name, static_cast<unsigned long long>(v));
+            out += line;
+        };
+        auto counter = [&](const char *name, const char *help, const Counter &c)
+        { counter_value(name, help, c.value()); };
+        auto gauge = [&](const char *name, const char *help, double v)
+        {
+            std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s gauge\n%s %.6g\n", name, help, name, name, v);
+            out += line;
+        };
+
+        counter("gateway_check_requests_total", "Accepted texts (single and batch items)", check_requests);
+        counter("gateway_check_rejected_total", "Rejected /check and /check/batch requests", check_rejected);
+        counter("gateway_check_shed_total", "Texts rejected by admission control (429)", check_shed);
+        counter("gateway_produce_errors_total", "Kafka produce() errors", produce_errors);
+        counter("gateway_delivered_total", "Messages acknowledged by Kafka", delivered);
+        counter("gateway_delivery_failed_total", "Messages that failed delivery", delivery_failed);
+        counter("gateway_results_consumed_total", "Results stored in the cache", results_consumed);
+        counter("gateway_results_malformed_total", "Malformed messages in the results topic", results_malformed);
+        counter("gateway_result_cache_hits_total", "GET /result served from the cache", cache_hits);
+        counter("gateway_result_cache_misses_total", "GET /result without a cached result", cache_misses);
+        counter("gateway_result_ttl_evictions_total", "Results removed by TTL", ttl_evictions);
+        counter_value("gateway_result_budget_evictions_total", "Results evicted before TTL by the memory budget",
+                      g.cache_evictions);
+        gauge("gateway_result_cache_size", "Results currently cached", double(g.cache_size));
+        gauge("gateway_result_cache_bytes", "Result cache memory (tables and used arena)", double(g.cache_bytes));
+        gauge("gateway_result_cache_bytes_per_entry", "Result cache memory per cached result",
+              g.cache_size ? double(g.cache_bytes) / double(g.cache_size) : 0.0);
+        gauge("gateway_result_waiters", "Pending long-poll requests", double(g.waiters));
+        gauge("gateway_producer_queue_messages", "Messages not yet acknowledged by Kafka", double(g.queue_messages));
+        gauge("gateway_producer_queue_bytes", "Payload bytes not yet acknowledged by Kafka", double(g.queue_bytes));
+        gauge("gateway_delivery_avg_seconds", "Moving average of delivery latency", double(g.delivery_avg_us) / 1e6);
+
+        check_parse.write(out, "gateway_check_parse_seconds", "Time to validate a /check body");
+        produce_call.write(out, "gateway_produce_call_seconds", "Time spent inside producer produce()");
+        delivery.write(out, "gateway_delivery_seconds", "Produce to delivery report latency");
+        consume_to_cache.write(out, "gateway_consume_to_cache_seconds", "Result consumed to cached latency");
+        end_to_end.write(out, "gateway_end_to_end_seconds", "Request timestamp to result cached latency");
+        return out;
+    }
+};
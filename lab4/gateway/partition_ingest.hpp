@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <librdkafka/rdkafkacpp.h>
+
+#include "async_log.hpp"
+
+// Поток на каждый назначенный раздел text_results.
+//
+// rebalance_cb отцепляет очередь раздела от общей очереди consumer (forward(NULL))
+// и запускает поток, который забирает сообщения пачками прямо из неё. Обработанные
+// смещения сохраняются offsets_store, коммитит их librdkafka (enable.auto.commit)
+// раз в auto.commit.interval.ms -- без синхронного похода к брокеру на сообщение.
+// Основной поток consumer продолжает звать consume(): на нём выполняются колбэки
+// ребалансировки и приходят ошибки.
+class PartitionIngest : public RdKafka::RebalanceCb
+{
+public:
+    using Handler = std::function<void(RdKafka::Message &)>;
+
+    PartitionIngest(AsyncLogger &log, size_t batch_size, Handler handler)
+        : log_(log), batch_size_(batch_size > 0 ? batch_size : 1), handler_(std::move(handler)) {}
+
+    ~PartitionIngest() { stop_all(); }
+
+    PartitionIngest(const PartitionIngest &) = delete;
+    PartitionIngest &operator=(const PartitionIngest &) = delete;
+
+    // Вызывается librdkafka из consume()/close() потока consumer.
+    void rebalance_cb(RdKafka::KafkaConsumer *consumer, RdKafka::ErrorCode err,
+                      std::vector<RdKafka::TopicPartition *> &partitions) override
+    {
+        if (err == RdKafka::ERR__ASSIGN_PARTITIONS)
+        {
+            // очереди отцепляются до assign: иначе первые сообщения успели бы уйти в общую очередь
+            for (RdKafka::TopicPartition *tp : partitions)
+                start(consumer, tp->topic(), tp->partition());
+            consumer->assign(partitions);
+            log_.info("partitions_assigned", {{"count", partitions.size()}, {"ingest_threads", ingestors_.size()}});
+        }
+        else
+        {
+            // потоки дорабатывают текущую пачку и сохраняют её смещения до unassign
+            stop_all();
+            consumer->unassign();
+            log_.info("partitions_revoked", {{"count", partitions.size()}});
+        }
+    }
+
+    // Останавливает все потоки; вызывается из потока consumer (или после него).
+    void stop_all()
+    {
+        for (auto &ing : ingestors_)
+            ing->stop.store(true, std::memory_order_relaxed);
+        for (auto &ing : ingestors_)
+        {
+            if (ing->thread.joinable())
+                ing->thread.join();
+        }
+        ingestors_.clear();
+    }
+
+    // Сообщение, всё же пришедшее через общую очередь consumer (гонка при назначении).
+    void handle_and_store(RdKafka::KafkaConsumer *consumer, RdKafka::Message &msg)
+    {
+        handler_(msg);
+        store_offset(consumer, msg.topic_name(), msg.partition(), msg.offset() + 1);
+    }
+
+private:
+    static constexpr int kPollMs = 100;
+
+    struct Ingestor
+    {
+        std::string topic;
+        int32_t partition = 0;
+        std::unique_ptr<RdKafka::Queue> queue;
+        std::atomic<bool> stop{false};
+        std::thread thread;
+    };
+
+    void start(RdKafka::KafkaConsumer *consumer, const std::string &topic, int32_t partition)
+    {
+        std::unique_ptr<RdKafka::TopicPartition> tp(RdKafka::TopicPartition::create(topic, partition));
+        auto ing = std::make_unique<Ingestor>();
+        ing->topic = topic;
+        ing->partition = partition;
+        ing->queue.reset(consumer->get_partition_queue(tp.get()));
+        if (!ing->queue)
+        {
+            log_.error("partition_queue_failed", {{"topic", topic}, {"partition", partition}});
+            return; // сообщения раздела пойдут через общую очередь
+        }
+        ing->queue->forward(nullptr);
+        Ingestor *raw = ing.get();
+        ing->thread = std::thread([this, consumer, raw]
+                                  { run(consumer, *raw); });
+        ingestors_.push_back(std::move(ing));
+    }
+
+    // Первое сообщение ждём kPollMs, остальные забираем без ожидания до batch_size_.
+    void run(RdKafka::KafkaConsumer *consumer, Ingestor &ing)
+    {
+        std::vector<std::unique_ptr<RdKafka::Message>> batch;
+        batch.reserve(batch_size_);
+        while (!ing.stop.load(std::memory_order_relaxed))
+        {
+            batch.clear();
+            int timeout = kPollMs;
+            while (batch.size() < batch_size_)
+            {
+                std::unique_ptr<RdKafka::Message> msg(ing.queue->consume(timeout));
+                if (!msg || msg->err() == RdKafka::ERR__TIMED_OUT)
+                    break;
+                if (msg->err() == RdKafka::ERR_NO_ERROR)
+                {
+                    batch.push_back(std::move(msg));
+                    timeout = 0;
+                }
+                else if (msg->err() != RdKafka::ERR__PARTITION_EOF)
+                {
+                    log_.error("consume_failed", {{"partition", ing.partition}, {"error", msg->errstr()}});
+                    break;
+                }
+            }
+            if (batch.empty())
+                continue;
+
+            for (auto &msg : batch)
+                handler_(*msg);
+            // битые сообщения тоже сохраняются, чтобы не застрять
+            store_offset(consumer, ing.topic, ing.partition, batch.back()->offset() + 1);
+        }
+    }
+
+    void store_offset(RdKafka::KafkaConsumer *consumer, const std::string &topic, int32_t partition, int64_t next)
+    {
+        std::vector<RdKafka::TopicPartition *> offsets{RdKafka::TopicPartition::create(topic, partition, next)};
+        RdKafka::ErrorCode err = consumer->offsets_store(offsets);
+        if (err != RdKafka::ERR_NO_ERROR)
+            log_.warn("offsets_store_failed", {{"partition", partition}, {"error", RdKafka::err2str(err)}});
+        RdKafka::TopicPartition::destroy(offsets);
+    }
+
+    AsyncLogger &log_;
+    const size_t batch_size_;
+    Handler handler_;
+    std::vector<std::unique_ptr<Ingestor>> ingestors_; // только из потока consumer
+};
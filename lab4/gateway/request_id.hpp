@@ -0,0 +1,167 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+
+// request_id: 128 бит, снаружи -- 32 hex-символа в нижнем регистре.
+//
+// Генерация без локов и аллокаций: у каждого потока две последовательности
+// splitmix64 (счётчик Вейля + перемешивание) со случайными стартами. Перемешивание
+// биективно, поэтому младшая половина не повторяется внутри потока 2^64 вызовов,
+// а совпадение между потоками -- это совпадение 128 случайных бит.
+// Двоичный вид (16 байт) годится как ключ кэша вместо std::string.
+struct RequestId
+{
+    static constexpr size_t kHexLen = 32;
+
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    // Текстовый вид в фиксированном буфере; живёт на стеке вызывающего.
+    struct Hex
+    {
+        char data[kHexLen];
+
+        std::string_view view() const { return {data, kHexLen}; }
+        std::string str() const { return {data, kHexLen}; }
+    };
+
+    static RequestId generate()
+    {
+        thread_local Stream s = Stream::seeded();
+        return RequestId{s.next_hi(), s.next_lo()};
+    }
+
+    void to_hex(char *out) const
+    {
+        write_hex64(hi, out);
+        write_hex64(lo, out + 16);
+    }
+
+    Hex hex() const
+    {
+        Hex h;
+        to_hex(h.data);
+        return h;
+    }
+
+    std::string str() const { return hex().str(); }
+
+    // Ровно 32 hex-символа (регистр любой); иначе false и id не меняется.
+    static bool parse(std::string_view s, RequestId &id)
+    {
+        if (s.size() != kHexLen)
+            return false;
+        uint64_t h = 0, l = 0;
+        if (!read_hex64(s.data(), h) || !read_hex64(s.data() + 16, l))
+            return false;
+        id.hi = h;
+        id.lo = l;
+        return true;
+    }
+
+    friend bool operator==(const RequestId &a, const RequestId &b) { return a.hi == b.hi && a.lo == b.lo; }
+    friend bool operator!=(const RequestId &a, const RequestId &b) { return !(a == b); }
+
+private:
+    struct Stream
+    {
+        uint64_t hi_state;
+        uint64_t lo_state;
+
+        static Stream seeded()
+        {
+            std::random_device rd;
+            const uint64_t t = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            const uint64_t a = (uint64_t{rd()} << 32) ^ rd();
+            const uint64_t b = (uint64_t{rd()} << 32) ^ rd();
+            return Stream{a ^ mix(t), b ^ mix(t + kGamma)};
+        }
+
+        uint64_t next_hi() { return mix(hi_state += kGamma); }
+        uint64_t next_lo() { return mix(lo_state += kGamma); }
+    };
+
+    static constexpr uint64_t kGamma = 0x9e3779b97f4a7c15ULL;
+
+    // финализатор splitmix64
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // байт -> две hex-цифры
+    struct HexPairs
+    {
+        char pairs[256][2];
+
+        constexpr HexPairs() : pairs()
+        {
+            const char *digits = "0123456789abcdef";
+            for (int i = 0; i < 256; ++i)
+            {
+                pairs[i][0] = digits[i >> 4];
+                pairs[i][1] = digits[i & 0xF];
+            }
+        }
+    };
+
+    static void write_hex64(uint64_t v, char *out)
+    {
+        static constexpr HexPairs kPairs{};
+        for (int i = 7; i >= 0; --i)
+        {
+            std::memcpy(out + i * 2, kPairs.pairs[v & 0xFF], 2);
+            v >>= 8;
+        }
+    }
+
+    // символ -> значение hex-цифры, -1 -- не цифра
+    struct HexDigits
+    {
+        int8_t value[256];
+
+        constexpr HexDigits() : value()
+        {
+            for (int i = 0; i < 256; ++i)
+                value[i] = -1;
+            for (int i = 0; i < 10; ++i)
+                value['0' + i] = static_cast<int8_t>(i);
+            for (int i = 0; i < 6; ++i)
+            {
+                value['a' + i] = static_cast<int8_t>(10 + i);
+                value['A' + i] = static_cast<int8_t>(10 + i);
+            }
+        }
+    };
+
+    static bool read_hex64(const char *s, uint64_t &out)
+    {
+        static constexpr HexDigits kDigits{};
+        uint64_t v = 0;
+        int bad = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            const int d = kDigits.value[static_cast<unsigned char>(s[i])];
+            bad |= d; // у -1 выставлен знаковый бит
+            v = (v << 4) | static_cast<uint64_t>(d & 0xF);
+        }
+        out = v;
+        return bad >= 0;
+    }
+};
+
+// Сгенерированные id уже перемешаны; hi домешивается на случай id, пришедших снаружи (parse).
+struct RequestIdHash
+{
+    size_t operator()(const RequestId &id) const
+    {
+        return static_cast<size_t>(id.lo ^ (id.hi * 0x9e3779b97f4a7c15ULL));
+    }
+};
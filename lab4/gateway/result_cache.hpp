@@ -0,0 +1,435 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include "request_id.hpp"
+
+// Кэш результатов, разбитый на шарды по хешу request_id. У каждого шарда свой
+// shared_mutex: чтения /result на разных шардах не блокируют друг друга,
+// читатели одного шарда не блокируют друг друга, а вставка и TTL-очистка
+// держат только один шард за раз.
+//
+// Шард -- это кольцевой буфер с телами результатов и таблица с открытой адресацией
+// (ключ -- 16 байт RequestId) со смещениями записей в буфере. TTL у всех записей
+// одинаковый, поэтому порядок вставки совпадает с порядком истечения: новые записи
+// дописываются в голову кольца, а TTL-очистка и вытеснение по бюджету снимают
+// самые старые с хвоста. Память шарда ограничена сверху: кольцо выделяется
+// один раз, таблица растёт не дальше своей доли бюджета.
+class ResultCache
+{
+public:
+    // Максимум записей, удаляемых за одно взятие лока шарда.
+    static constexpr size_t kExpireSlice = 256;
+
+    // max_bytes -- бюджет на весь кэш; четверть доли шарда отводится таблице.
+    ResultCache(size_t shards, size_t max_bytes)
+    {
+        size_t n = 1;
+        while (n < shards)
+            n <<= 1;
+        shard_bits_ = 0;
+        for (size_t k = n; k > 1; k >>= 1)
+            shard_bits_++;
+        shard_count_ = n;
+
+        const size_t shard_budget = std::max<size_t>(max_bytes / n, kMinShardBytes);
+        table_budget_ = shard_budget / 4;
+        const size_t ring_bytes = (shard_budget - table_budget_) & ~size_t{7};
+        shards_.reset(new Shard[n]);
+        for (size_t i = 0; i < n; ++i)
+        {
+            shards_[i].ring_cap = ring_bytes;
+            shards_[i].ring.reset(new char[ring_bytes]); // страницы выделяются ядром по мере записи
+            rehash(shards_[i], kInitialSlots);
+        }
+    }
+
+    // false -- id не 32 hex или тело больше кольца шарда.
+    bool put(const std::string &id, std::string_view body, int64_t inserted_ms)
+    {
+        RequestId key;
+        if (!RequestId::parse(id, key))
+            return false;
+        const uint64_t h = hash(key);
+        Shard &sh = shard_for(h);
+        std::unique_lock<std::shared_mutex> lk(sh.mtx);
+        uint64_t pos;
+        if (!append(sh, key, inserted_ms, body, pos))
+            return false;
+        size_t idx = find(sh, key, h);
+        if (idx != kNone)
+        {
+            // прежняя запись остаётся в кольце мёртвой и при снятии с хвоста пропускается
+            sh.slots[idx].pos = pos;
+            return true;
+        }
+        reserve_one(sh);
+        insert(sh, key, h, pos);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Копирует тело в out (буфер вызывающего переиспользуется между запросами):
+    // после выхода из-под лока место в кольце может быть перезаписано.
+    bool copy_to(const std::string &id, std::string &out) const
+    {
+        RequestId key;
+        if (!RequestId::parse(id, key))
+            return false;
+        const uint64_t h = hash(key);
+        const Shard &sh = shard_for(h);
+        std::shared_lock<std::shared_mutex> lk(sh.mtx);
+        const size_t idx = find(sh, key, h);
+        if (idx == kNone)
+            return false;
+        const char *rec = sh.ring.get() + sh.slots[idx].pos % sh.ring_cap;
+        RecordHeader hdr;
+        std::memcpy(&hdr, rec, sizeof(hdr));
+        out.assign(rec + sizeof(hdr), hdr.len);
+        return true;
+    }
+
+    std::shared_ptr<const std::string> get(const std::string &id) const
+    {
+        std::string body;
+        if (!copy_to(id, body))
+            return nullptr;
+        return std::make_shared<const std::string>(std::move(body));
+    }
+
+    // Удаляет не более budget записей старше ttl_ms, продолжая с шарда, на котором
+    // остановился прошлый вызов. Лок шарда держится не дольше kExpireSlice записей.
+    size_t expire(int64_t now, int64_t ttl_ms, size_t budget)
+    {
+        size_t erased = 0;
+        for (size_t visited = 0; visited < shard_count_ && budget > 0; ++visited)
+        {
+            Shard &sh = shards_[expire_cursor_];
+            bool shard_done = false;
+            while (!shard_done && budget > 0)
+            {
+                std::unique_lock<std::shared_mutex> lk(sh.mtx);
+                size_t slice = std::min(budget, kExpireSlice);
+                while (slice > 0)
+                {
+                    RecordHeader hdr;
+                    if (!tail_record(sh, hdr) || now - hdr.inserted_ms <= ttl_ms)
+                    {
+                        shard_done = true;
+                        break;
+                    }
+                    if (pop_tail(sh))
+                        erased++;
+                    slice--;
+                    budget--;
+                }
+            }
+            if (shard_done)
+                expire_cursor_ = (expire_cursor_ + 1) & (shard_count_ - 1);
+        }
+        size_.fetch_sub(erased, std::memory_order_relaxed);
+        return erased;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t shard_count() const { return shard_count_; }
+
+    // Записи, вытесненные до истечения TTL из-за бюджета памяти.
+    uint64_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+
+    // Занятая память: таблицы целиком и использованная часть колец (вместе с мёртвыми записями).
+    size_t memory_bytes() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < shard_count_; ++i)
+        {
+            const Shard &sh = shards_[i];
+            std::shared_lock<std::shared_mutex> lk(sh.mtx);
+            total += table_bytes(sh.cap) + static_cast<size_t>(sh.head - sh.tail);
+        }
+        return total;
+    }
+
+private:
+    static constexpr size_t kNone = ~size_t{0};
+    static constexpr size_t kGroup = 8; // ячеек в группе, управляющие байты читаются одним uint64
+    static constexpr size_t kInitialSlots = 64;
+    static constexpr size_t kMinShardBytes = 64u << 10;
+
+    // управляющий байт ячейки: 0..127 -- занята (7 бит хеша), иначе пуста или удалена
+    static constexpr int8_t kEmpty = -128;
+    static constexpr int8_t kDeleted = -2;
+    static constexpr uint64_t kLsbs = 0x0101010101010101ull;
+    static constexpr uint64_t kMsbs = 0x8080808080808080ull;
+
+    struct Slot
+    {
+        RequestId key;
+        uint64_t pos; // логическое смещение записи в кольце
+    };
+
+    // Запись в кольце: заголовок и тело, выровнено на 8. Запись не переходит через
+    // конец кольца: остаток в конце пропускается (kSkip, если в него влез заголовок).
+    struct RecordHeader
+    {
+        RequestId key;
+        int64_t inserted_ms;
+        uint32_t len;
+        uint32_t flags;
+    };
+    static constexpr uint32_t kSkip = 1;
+
+    // выравнивание по строке кэша: локи соседних шардов не делят cache line
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mtx;
+        std::unique_ptr<int8_t[]> ctrl;
+        std::unique_ptr<Slot[]> slots;
+        size_t cap = 0; // кратно kGroup, число групп -- степень двойки
+        size_t used = 0;
+        size_t tombstones = 0;
+        std::unique_ptr<char[]> ring;
+        size_t ring_cap = 0;
+        uint64_t head = 0; // логические смещения: физическое = pos % ring_cap
+        uint64_t tail = 0;
+    };
+
+    static uint64_t hash(const RequestId &key)
+    {
+        return static_cast<uint64_t>(RequestIdHash{}(key));
+    }
+
+    static size_t table_bytes(size_t cap) { return cap * (sizeof(Slot) + 1); }
+    static size_t max_load(size_t cap) { return cap - cap / 8; }
+    static size_t record_bytes(size_t len) { return (sizeof(RecordHeader) + len + 7) & ~size_t{7}; }
+
+    // --- таблица: группы по 8 управляющих байт, сравнение сразу всей группы (SWAR) ---
+
+    static uint64_t load_group(const int8_t *ctrl)
+    {
+        uint64_t g;
+        std::memcpy(&g, ctrl, sizeof(g));
+        return g;
+    }
+
+    // байты, равные h2 (возможны ложные совпадения -- ключ всё равно сравнивается)
+    static uint64_t match(uint64_t g, uint8_t h2)
+    {
+        const uint64_t x = g ^ (kLsbs * h2);
+        return (x - kLsbs) & ~x & kMsbs;
+    }
+
+    static uint64_t match_empty(uint64_t g) { return g & ~(g << 6) & kMsbs; }
+    static uint64_t match_free(uint64_t g) { return g & kMsbs; } // пустые и удалённые
+
+    static size_t first_byte(uint64_t mask) { return static_cast<size_t>(__builtin_ctzll(mask)) / 8; }
+
+    // Пробирование по группам (треугольные числа обходят все группы при их числе 2^k);
+    // старшие биты хеша выбирают шард, биты 7.. -- группу, младшие 7 -- управляющий байт.
+    static size_t find(const Shard &sh, const RequestId &key, uint64_t h)
+    {
+        const size_t mask = sh.cap / kGroup - 1;
+        size_t g = (h >> 7) & mask;
+        for (size_t step = 1; step <= mask + 1; ++step)
+        {
+            const uint64_t group = load_group(sh.ctrl.get() + g * kGroup);
+            for (uint64_t m = match(group, h & 0x7F); m; m &= m - 1)
+            {
+                const size_t idx = g * kGroup + first_byte(m);
+                if (sh.slots[idx].key == key)
+                    return idx;
+            }
+            if (match_empty(group))
+                return kNone;
+            g = (g + step) & mask;
+        }
+        return kNone;
+    }
+
+    static void insert(Shard &sh, const RequestId &key, uint64_t h, uint64_t pos)
+    {
+        const size_t mask = sh.cap / kGroup - 1;
+        size_t g = (h >> 7) & mask;
+        for (size_t step = 1;; ++step)
+        {
+            const uint64_t m = match_free(load_group(sh.ctrl.get() + g * kGroup));
+            if (m)
+            {
+                const size_t idx = g * kGroup + first_byte(m);
+                if (sh.ctrl[idx] == kDeleted)
+                    sh.tombstones--;
+                sh.ctrl[idx] = static_cast<int8_t>(h & 0x7F);
+                sh.slots[idx] = Slot{key, pos};
+                sh.used++;
+                return;
+            }
+            g = (g + step) & mask;
+        }
+    }
+
+    void erase(Shard &sh, size_t idx)
+    {
+        // поиск останавливается на группе с пустой ячейкой, значит через такую группу
+        // он никогда не проходил дальше -- ячейку можно сразу сделать пустой
+        const size_t g = idx / kGroup;
+        if (match_empty(load_group(sh.ctrl.get() + g * kGroup)))
+        {
+            sh.ctrl[idx] = kEmpty;
+        }
+        else
+        {
+            sh.ctrl[idx] = kDeleted;
+            sh.tombstones++;
+        }
+        sh.used--;
+    }
+
+    static void rehash(Shard &sh, size_t cap)
+    {
+        std::unique_ptr<int8_t[]> old_ctrl = std::move(sh.ctrl);
+        std::unique_ptr<Slot[]> old_slots = std::move(sh.slots);
+        const size_t old_cap = sh.cap;
+        sh.ctrl.reset(new int8_t[cap]);
+        std::memset(sh.ctrl.get(), static_cast<unsigned char>(kEmpty), cap);
+        sh.slots.reset(new Slot[cap]);
+        sh.cap = cap;
+        sh.used = 0;
+        sh.tombstones = 0;
+        for (size_t i = 0; i < old_cap; ++i)
+        {
+            if (old_ctrl[i] >= 0)
+                insert(sh, old_slots[i].key, hash(old_slots[i].key), old_slots[i].pos);
+        }
+    }
+
+    // Место под ещё одну запись в таблице: рост, пока таблица укладывается в свою долю
+    // бюджета, дальше -- вытеснение старейших записей с запасом в 1/16 таблицы, чтобы
+    // rehash (он же убирает удалённые ячейки) не повторялся на каждой вставке.
+    void reserve_one(Shard &sh)
+    {
+        if (sh.used + sh.tombstones + 1 <= max_load(sh.cap))
+            return;
+        size_t cap = sh.cap;
+        const size_t low_water = max_load(cap) - cap / 16;
+        if (sh.used + 1 > max_load(cap) / 2 && table_bytes(cap * 2) <= table_budget_)
+        {
+            cap *= 2;
+        }
+        else if (sh.used + 1 > low_water)
+        {
+            size_t evicted = 0;
+            while (sh.used + 1 > low_water && sh.head != sh.tail)
+                evicted += pop_tail(sh) ? 1 : 0;
+            count_evicted(evicted);
+        }
+        rehash(sh, cap);
+    }
+
+    // --- кольцо ---
+
+    // Дописывает запись, при нехватке места снимая старейшие с хвоста.
+    bool append(Shard &sh, const RequestId &key, int64_t inserted_ms, std::string_view body, uint64_t &pos)
+    {
+        const size_t need = record_bytes(body.size());
+        if (need > sh.ring_cap || body.size() > UINT32_MAX)
+            return false;
+        size_t evicted = 0;
+        size_t pad;
+        for (;;)
+        {
+            const size_t room = sh.ring_cap - sh.head % sh.ring_cap;
+            pad = need > room ? room : 0;
+            if (sh.head - sh.tail + pad + need <= sh.ring_cap)
+                break;
+            if (sh.head == sh.tail)
+            {
+                // пустое кольцо: сразу с начала
+                sh.head += pad;
+                sh.tail = sh.head;
+                continue;
+            }
+            evicted += pop_tail(sh) ? 1 : 0;
+        }
+        count_evicted(evicted);
+
+        if (pad >= sizeof(RecordHeader))
+        {
+            RecordHeader skip{};
+            skip.flags = kSkip;
+            std::memcpy(sh.ring.get() + sh.head % sh.ring_cap, &skip, sizeof(skip));
+        }
+        sh.head += pad;
+
+        RecordHeader hdr{key, inserted_ms, static_cast<uint32_t>(body.size()), 0};
+        char *rec = sh.ring.get() + sh.head % sh.ring_cap;
+        std::memcpy(rec, &hdr, sizeof(hdr));
+        std::memcpy(rec + sizeof(hdr), body.data(), body.size());
+        pos = sh.head;
+        sh.head += need;
+        return true;
+    }
+
+    // Пропускает хвостовые промежутки и читает заголовок старейшей записи (false -- кольцо пусто).
+    static bool tail_record(Shard &sh, RecordHeader &hdr)
+    {
+        while (sh.head != sh.tail)
+        {
+            const size_t room = sh.ring_cap - sh.tail % sh.ring_cap;
+            if (room >= sizeof(RecordHeader))
+            {
+                std::memcpy(&hdr, sh.ring.get() + sh.tail % sh.ring_cap, sizeof(hdr));
+                if (hdr.flags != kSkip)
+                    return true;
+            }
+            sh.tail += room;
+        }
+        return false;
+    }
+
+    // Снимает старейшую запись; true -- она была актуальной и удалена из таблицы.
+    bool pop_tail(Shard &sh)
+    {
+        RecordHeader hdr;
+        if (!tail_record(sh, hdr))
+            return false;
+        const uint64_t pos = sh.tail;
+        sh.tail += record_bytes(hdr.len);
+        const RequestId key = hdr.key;
+        const size_t idx = find(sh, key, hash(key));
+        if (idx == kNone || sh.slots[idx].pos != pos)
+            return false; // перезаписана более новой
+        erase(sh, idx);
+        return true;
+    }
+
+    void count_evicted(size_t n)
+    {
+        if (n == 0)
+            return;
+        size_.fetch_sub(n, std::memory_order_relaxed);
+        evictions_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    Shard &shard_for(uint64_t h) const
+    {
+        // старшие биты хеша: младшие выбирают группу внутри шарда
+        size_t idx = shard_bits_ ? static_cast<size_t>((h * 0x9E3779B97F4A7C15ull) >> (64 - shard_bits_)) : 0;
+        return shards_[idx];
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_count_ = 1;
+    unsigned shard_bits_ = 0;
+    size_t table_budget_ = 0;  // байт на таблицу одного шарда
+    size_t expire_cursor_ = 0; // только поток очистки
+    std::atomic<size_t> size_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Отложенные ответы на GET /result/:id?wait_ms=...
+// Ожидание -- это только запись в таблице (колбэк с перемещённым ResponseWriter),
+// HTTP-потоки не блокируются. Ожидание завершается либо когда consumer кладёт
+// результат в кэш (resolve), либо по дедлайну из отдельного потока таймеров.
+//
+// Колбэк вызывается ровно один раз и всегда вне лока:
+// body != nullptr -- результат готов, nullptr -- таймаут или остановка.
+class ResultWaiters
+{
+public:
+    using Body = std::shared_ptr<const std::string>;
+    using Callback = std::function<void(Body)>;
+
+    explicit ResultWaiters(size_t max_waiters) : max_waiters_(max_waiters)
+    {
+        timer_ = std::thread([this]
+                             { timer_loop(); });
+    }
+
+    ~ResultWaiters()
+    {
+        shutdown();
+    }
+
+    ResultWaiters(const ResultWaiters &) = delete;
+    ResultWaiters &operator=(const ResultWaiters &) = delete;
+
+    // lookup вызывается под локом таблицы: resolve() для того же id берёт тот же лок
+    // после вставки в кэш, поэтому результат не может проскочить между проверкой
+    // кэша и регистрацией ожидания. Счётчик active_ растёт до lookup, а resolve()
+    // читает его после вставки в кэш: либо lookup увидит результат, либо resolve -- ожидание.
+    // false -- ожидание не зарегистрировано (лимит или остановка), cb не вызывался.
+    template <class Lookup>
+    bool wait(const std::string &id, int64_t deadline_ms, Lookup &&lookup, Callback cb)
+    {
+        active_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Body ready;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (stopped_ || waiters_.size() >= max_waiters_)
+            {
+                active_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            ready = lookup();
+            if (!ready)
+            {
+                const uint64_t seq = next_seq_++;
+                auto dl = deadlines_.emplace(deadline_ms, seq);
+                waiters_.emplace(seq, Waiter{id, dl, std::move(cb)});
+                by_id_.emplace(id, seq);
+                if (dl == deadlines_.begin())
+                    cv_.notify_one(); // ближайший дедлайн сдвинулся
+                return true;
+            }
+        }
+        active_.fetch_sub(1, std::memory_order_relaxed);
+        cb(std::move(ready));
+        return true;
+    }
+
+    // Будит всех, кто ждёт id. Вызывать после вставки результата в кэш.
+    // Зовут все потоки приёма результатов: пока ожиданий нет, лок не берётся.
+    void resolve(const std::string &id, const Body &body)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (active_.load(std::memory_order_relaxed) == 0)
+            return;
+        std::vector<Callback> fire;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            auto range = by_id_.equal_range(id);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                auto w = waiters_.find(it->second);
+                deadlines_.erase(w->second.deadline);
+                fire.push_back(std::move(w->second.cb));
+                waiters_.erase(w);
+            }
+            by_id_.erase(range.first, range.second);
+            active_.fetch_sub(fire.size(), std::memory_order_relaxed);
+        }
+        for (auto &cb : fire)
+            cb(body);
+    }
+
+    // Отвечает всем оставшимся ожиданиям (как по таймауту) и останавливает поток таймеров.
+    void shutdown()
+    {
+        std::vector<Callback> fire;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (stopped_)
+                return;
+            stopped_ = true;
+            for (auto &kv : waiters_)
+                fire.push_back(std::move(kv.second.cb));
+            active_.fetch_sub(waiters_.size(), std::memory_order_relaxed);
+            waiters_.clear();
+            by_id_.clear();
+            deadlines_.clear();
+        }
+        cv_.notify_all();
+        if (timer_.joinable())
+            timer_.join();
+        for (auto &cb : fire)
+            cb(nullptr);
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return waiters_.size();
+    }
+
+private:
+    // deadline -> seq; итераторы std::multimap стабильны, поэтому их можно хранить
+    using Deadlines = std::multimap<int64_t, uint64_t>;
+
+    struct Waiter
+    {
+        std::string id;
+        Deadlines::iterator deadline;
+        Callback cb;
+    };
+
+    static int64_t now_ms()
+    {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    void timer_loop()
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        while (!stopped_)
+        {
+            if (deadlines_.empty())
+            {
+                cv_.wait(lk);
+                continue;
+            }
+            const int64_t next = deadlines_.begin()->first;
+            const int64_t now = now_ms();
+            if (next > now)
+            {
+                cv_.wait_for(lk, std::chrono::milliseconds(next - now));
+                continue;
+            }
+
+            std::vector<Callback> fire;
+            while (!deadlines_.empty() && deadlines_.begin()->first <= now)
+            {
+                const uint64_t seq = deadlines_.begin()->second;
+                auto w = waiters_.find(seq);
+                auto range = by_id_.equal_range(w->second.id);
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    if (it->second == seq)
+                    {
+                        by_id_.erase(it);
+                        break;
+                    }
+                }
+                fire.push_back(std::move(w->second.cb));
+                waiters_.erase(w);
+                deadlines_.erase(deadlines_.begin());
+            }
+            active_.fetch_sub(fire.size(), std::memory_order_relaxed);
+            lk.unlock();
+            for (auto &cb : fire)
+                cb(nullptr);
+            lk.lock();
+        }
+    }
+
+    const size_t max_waiters_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stopped_ = false;
+    uint64_t next_seq_ = 0;
+    std::atomic<size_t> active_{0}; // зарегистрированные ожидания и wait() в процессе
+    std::unordered_map<uint64_t, Waiter> waiters_;       // seq -> ожидание
+    std::unordered_multimap<std::string, uint64_t> by_id_; // request_id -> seq
+    Deadlines deadlines_;
+
+    std::thread timer_;
+};
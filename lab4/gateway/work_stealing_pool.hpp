@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул с очередью на каждый поток и кражей задач.
+// Задачи извне (HTTP-потоки) раздаются по очередям по кругу, задача из потока
+// пула -- в его собственную очередь. Поток берёт свои задачи с конца (LIFO,
+// данные ещё в кэше), а опустев, крадёт чужие с начала: длинная задача (большой
+// текст) не задерживает очередь своего потока -- её разбирают соседи.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(size_t threads)
+    {
+        if (threads == 0)
+            threads = 1;
+        queues_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            queues_.push_back(std::make_unique<Queue>());
+        threads_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            threads_.emplace_back([this, i]
+                                  { worker_loop(i); });
+    }
+
+    // Дорабатывает все поставленные задачи.
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(sleep_mtx_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto &t : threads_)
+            t.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    size_t size() const { return threads_.size(); }
+
+    // Задач в очередях (ещё не взятых потоками).
+    size_t pending() const { return pending_.load(std::memory_order_relaxed); }
+
+    void submit(std::function<void()> task)
+    {
+        const size_t i = (tls_pool_ == this) ? tls_index_
+                                             : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        // счётчик растёт до появления задачи в очереди: он не бывает меньше числа задач
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lk(queues_[i]->mtx);
+            queues_[i]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lk(sleep_mtx_);
+        }
+        sleep_cv_.notify_one();
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool take(size_t self, std::function<void()> &task)
+    {
+        {
+            Queue &own = *queues_[self];
+            std::lock_guard<std::mutex> lk(own.mtx);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues_.size(); ++k)
+        {
+            Queue &victim = *queues_[(self + k) % queues_.size()];
+            std::lock_guard<std::mutex> lk(victim.mtx);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(size_t self)
+    {
+        tls_pool_ = this;
+        tls_index_ = self;
+        std::function<void()> task;
+        while (true)
+        {
+            if (take(self, task))
+            {
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(sleep_mtx_);
+            sleep_cv_.wait(lk, [this]
+                           { return stop_ || pending_.load(std::memory_order_relaxed) > 0; });
+            if (stop_ && pending_.load(std::memory_order_relaxed) == 0)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> pending_{0};
+
+    std::mutex sleep_mtx_;
+    std::condition_variable sleep_cv_;
+    bool stop_ = false;
+
+    static inline thread_local WorkStealingPool *tls_pool_ = nullptr;
+    static inline thread_local size_t tls_index_ = 0;
+};
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "corpus.hpp"
+#include "http_client.hpp"
+
+// Генератор нагрузки с открытым циклом: запросы POST /check уходят по расписанию
+// (--rate в секунду) независимо от того, успевает ли сервис, а результат забирается
+// long-poll GET /result/{id}?wait_ms=... отдельными потоками.
+//
+// Задержка считается от запланированного момента отправки, а не от фактического:
+// если сервис (или сам генератор) отстаёт, ожидание в очереди входит в задержку --
+// поправка на coordinated omission, как в wrk2. accept -- до ответа на POST,
+// complete -- до получения результата.
+//
+// Поток-поллер ждёт один id за раз, поэтому при нехватке --pollers принятые id стоят
+// в очереди к поллерам, и это ожидание входит в complete: тогда complete -- верхняя
+// оценка задержки сервиса. Само ожидание печатается строкой poll_queue; если оно
+// заметно, нужно больше --pollers.
+//
+//   loadgen --url=localhost:8080 --rate=500 --duration=30 --mix=256:70,4096:25,65536:5
+
+using Clock = std::chrono::steady_clock;
+
+struct SizeClass
+{
+    size_t bytes;
+    unsigned weight;
+    std::string body; // готовое тело POST /check
+};
+
+struct Options
+{
+    std::string url = "localhost:8080";
+    double rate = 100.0;
+    double duration_s = 10.0;
+    double warmup_s = 1.0;
+    size_t connections = 8; // потоки-отправители, у каждого своё соединение
+    size_t pollers = 32;    // потоки, ждущие результатов
+    std::string mix = "1024:1";
+    std::string kind = "ru";
+    int timeout_ms = 30000; // результат не пришёл -- запрос считается потерянным
+    double max_p99_ms = 0;  // пороги для CI: нарушение -- код возврата 1
+    double min_throughput = 0;
+};
+
+static bool parse_flag(const char *arg, const char *name, std::string &out)
+{
+    const size_t n = std::strlen(name);
+    if (std::strncmp(arg, name, n) != 0 || arg[n] != '=')
+        return false;
+    out = arg + n + 1;
+    return true;
+}
+
+static bool parse_options(int argc, char **argv, Options &o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string v;
+        if (parse_flag(argv[i], "--url", v))
+            o.url = v;
+        else if (parse_flag(argv[i], "--rate", v))
+            o.rate = std::atof(v.c_str());
+        else if (parse_flag(argv[i], "--duration", v))
+            o.duration_s = std::atof(v.c_str());
+        else if (parse_flag(argv[i], "--warmup", v))
+            o.warmup_s = std::atof(v.c_str());
+        else if (parse_flag(argv[i], "--connections", v))
+            o.connections = std::max<size_t>(1, std::strtoull(v.c_str(), nullptr, 10));
+        else if (parse_flag(argv[i], "--pollers", v))
+            o.pollers = std::max<size_t>(1, std::strtoull(v.c_str(), nullptr, 10));
+        else if (parse_flag(argv[i], "--mix", v))
+            o.mix = v;
+        else if (parse_flag(argv[i], "--kind", v))
+            o.kind = v;
+        else if (parse_flag(argv[i], "--timeout_ms", v))
+            o.timeout_ms = std::atoi(v.c_str());
+        else if (parse_flag(argv[i], "--max_p99_ms", v))
+            o.max_p99_ms = std::atof(v.c_str());
+        else if (parse_flag(argv[i], "--min_throughput", v))
+            o.min_throughput = std::atof(v.c_str());
+        else
+        {
+            std::cerr << "unknown flag: " << argv[i] << "\n";
+            return false;
+        }
+    }
+    if (o.rate <= 0 || o.duration_s <= 0)
+    {
+        std::cerr << "--rate and --duration must be positive\n";
+        return false;
+    }
+    return true;
+}
+
+static std::string json_escape(std::string_view s)
+{
+    std::string out;
+    out.reserve(s.size() + s.size() / 16 + 2);
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", static_cast<unsigned>(c));
+                out += esc;
+            }
+            else
+                out += c;
+        }
+    }
+    return out;
+}
+
+// "256:70,4096:25,65536:5" -- размер текста в байтах : вес
+static bool parse_mix(const std::string &mix, CorpusKind kind, std::vector<SizeClass> &out)
+{
+    const std::string lang = corpus_kind_lang(kind);
+    size_t pos = 0;
+    while (pos < mix.size())
+    {
+        size_t comma = mix.find(',', pos);
+        if (comma == std::string::npos)
+            comma = mix.size();
+        const std::string item = mix.substr(pos, comma - pos);
+        const size_t colon = item.find(':');
+        SizeClass sc;
+        sc.bytes = std::strtoull(item.c_str(), nullptr, 10);
+        sc.weight = colon == std::string::npos ? 1u : static_cast<unsigned>(std::strtoul(item.c_str() + colon + 1, nullptr, 10));
+        if (sc.bytes == 0 || sc.weight == 0)
+            return false;
+        sc.body = "{\"text\":\"" + json_escape(make_corpus(kind, sc.bytes, 42 + out.size())) +
+                  "\",\"language\":\"" + lang + "\"}";
+        out.push_back(std::move(sc));
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+static CorpusKind parse_kind(const std::string &s)
+{
+    if (s == "en")
+        return CorpusKind::En;
+    if (s == "mixed")
+        return CorpusKind::Mixed;
+    if (s == "junk")
+        return CorpusKind::Junk;
+    return CorpusKind::Ru;
+}
+
+// Задержки одного потока; сливаются в конце.
+struct Samples
+{
+    std::vector<int64_t> accept_us;
+    std::vector<int64_t> poll_queue_us;             // от приёма id до начала его long-poll
+    std::vector<std::vector<int64_t>> complete_us; // по классам размера
+    uint64_t rejected = 0;                          // POST вернул не 200 (429, 503, ...)
+    uint64_t errors = 0;                            // сетевая ошибка или непонятный ответ
+    uint64_t lost = 0;                              // результат не пришёл за timeout_ms
+    int64_t max_send_lag_us = 0;                    // насколько отставал сам генератор
+};
+
+struct Pending
+{
+    std::string id;
+    Clock::time_point intended;
+    Clock::time_point accepted;
+    size_t size_class;
+};
+
+// Очередь принятых запросов для потоков, ждущих результат.
+class PendingQueue
+{
+public:
+    void push(Pending p)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            q_.push_back(std::move(p));
+        }
+        cv_.notify_one();
+    }
+
+    // false -- очередь закрыта и пуста
+    bool pop(Pending &out)
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cv_.wait(lk, [this]
+                 { return closed_ || !q_.empty(); });
+        if (q_.empty())
+            return false;
+        out = std::move(q_.front());
+        q_.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Pending> q_;
+    bool closed_ = false;
+};
+
+static int64_t us_between(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count();
+}
+
+// request_id из {"request_id":"..."} без JSON-библиотеки
+static bool extract_request_id(const std::string &body, std::string &id)
+{
+    size_t at = body.find("\"request_id\"");
+    if (at == std::string::npos)
+        return false;
+    at = body.find(':', at);
+    const size_t from = at == std::string::npos ? at : body.find('"', at);
+    if (from == std::string::npos)
+        return false;
+    const size_t to = body.find('"', from + 1);
+    if (to == std::string::npos || to == from + 1)
+        return false;
+    id.assign(body, from + 1, to - from - 1);
+    return true;
+}
+
+struct Percentiles
+{
+    size_t n = 0;
+    double p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0, mean = 0; // мс
+};
+
+static Percentiles percentiles(std::vector<int64_t> &us)
+{
+    Percentiles p;
+    p.n = us.size();
+    if (us.empty())
+        return p;
+    std::sort(us.begin(), us.end());
+    auto at = [&](double q)
+    { return double(us[std::min(us.size() - 1, size_t(q * double(us.size())))]) / 1000.0; };
+    p.p50 = at(0.50);
+    p.p90 = at(0.90);
+    p.p99 = at(0.99);
+    p.p999 = at(0.999);
+    p.max = double(us.back()) / 1000.0;
+    double sum = 0;
+    for (int64_t v : us)
+        sum += double(v);
+    p.mean = sum / double(us.size()) / 1000.0;
+    return p;
+}
+
+static void print_line(const std::string &name, const Percentiles &p)
+{
+    std::printf("%-16s n=%-8zu p50=%9.3f p90=%9.3f p99=%9.3f p99.9=%9.3f max=%9.3f mean=%9.3f ms\n",
+                name.c_str(), p.n, p.p50, p.p90, p.p99, p.p999, p.max, p.mean);
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts))
+        return 2;
+    std::string host;
+    uint16_t port = 0;
+    if (!HttpClient::parse_address(opts.url, host, port))
+    {
+        std::cerr << "bad --url: " << opts.url << " (expected host:port)\n";
+        return 2;
+    }
+    std::vector<SizeClass> classes;
+    if (!parse_mix(opts.mix, parse_kind(opts.kind), classes))
+    {
+        std::cerr << "bad --mix: " << opts.mix << " (expected bytes:weight,...)\n";
+        return 2;
+    }
+    unsigned total_weight = 0;
+    for (const auto &c : classes)
+        total_weight += c.weight;
+
+    const size_t total = static_cast<size_t>(opts.rate * opts.duration_s);
+    const std::chrono::nanoseconds period(static_cast<int64_t>(1e9 / opts.rate));
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    const Clock::time_point measure_from = start + std::chrono::microseconds(static_cast<int64_t>(opts.warmup_s * 1e6));
+
+    std::vector<Samples> sender_samples(opts.connections), poller_samples(opts.pollers);
+    for (auto &s : poller_samples)
+        s.complete_us.resize(classes.size());
+    PendingQueue pending;
+
+    // Отправитель t берёт запросы t, t + connections, ...; момент i-го -- start + i * period.
+    auto sender = [&](size_t t)
+    {
+        HttpClient client(host, port);
+        HttpClient::Response resp;
+        Samples &s = sender_samples[t];
+        SplitMix64 rng{0x5EED + t};
+        for (size_t i = t; i < total; i += opts.connections)
+        {
+            const Clock::time_point intended = start + period * static_cast<int64_t>(i);
+            std::this_thread::sleep_until(intended);
+            s.max_send_lag_us = std::max(s.max_send_lag_us, us_between(intended, Clock::now()));
+
+            size_t cls = 0;
+            for (unsigned r = static_cast<unsigned>(rng.below(total_weight)); r >= classes[cls].weight; ++cls)
+                r -= classes[cls].weight;
+
+            std::string id;
+            if (!client.post("/check", classes[cls].body, resp))
+            {
+                s.errors++;
+                continue;
+            }
+            const Clock::time_point accepted = Clock::now();
+            if (resp.status != 200)
+            {
+                s.rejected++;
+                continue;
+            }
+            if (!extract_request_id(resp.body, id))
+            {
+                s.errors++;
+                continue;
+            }
+            if (intended >= measure_from)
+                s.accept_us.push_back(us_between(intended, accepted));
+            pending.push(Pending{std::move(id), intended, accepted, cls});
+        }
+    };
+
+    auto poller = [&](size_t t)
+    {
+        HttpClient client(host, port);
+        HttpClient::Response resp;
+        Samples &s = poller_samples[t];
+        Pending p;
+        while (pending.pop(p))
+        {
+            if (p.intended >= measure_from)
+                s.poll_queue_us.push_back(us_between(p.accepted, Clock::now()));
+            const Clock::time_point deadline = p.intended + std::chrono::milliseconds(opts.timeout_ms);
+            bool done = false;
+            bool failed = false;
+            while (!done)
+            {
+                const int64_t left_ms = us_between(Clock::now(), deadline) / 1000;
+                if (left_ms <= 0)
+                    break;
+                if (!client.get("/result/" + p.id + "?wait_ms=" + std::to_string(left_ms), resp) || resp.status != 200)
+                {
+                    failed = true;
+                    break;
+                }
+                done = resp.body.find("\"processing\"") == std::string::npos;
+            }
+            if (!done)
+            {
+                // каждый запрос учитывается один раз: либо ошибка, либо потерян по таймауту
+                if (failed)
+                    s.errors++;
+                else
+                    s.lost++;
+                continue;
+            }
+            if (p.intended >= measure_from)
+                s.complete_us[p.size_class].push_back(us_between(p.intended, Clock::now()));
+        }
+    };
+
+    std::printf("url=%s rate=%.1f/s duration=%.1fs warmup=%.1fs connections=%zu pollers=%zu mix=%s kind=%s\n",
+                opts.url.c_str(), opts.rate, opts.duration_s, opts.warmup_s, opts.connections, opts.pollers,
+                opts.mix.c_str(), opts.kind.c_str());
+    std::fflush(stdout);
+
+    std::vector<std::thread> senders, pollers;
+    for (size_t t = 0; t < opts.pollers; ++t)
+        pollers.emplace_back(poller, t);
+    for (size_t t = 0; t < opts.connections; ++t)
+        senders.emplace_back(sender, t);
+    for (auto &t : senders)
+        t.join();
+    const Clock::time_point sent_done = Clock::now();
+    pending.close();
+    for (auto &t : pollers)
+        t.join();
+    const Clock::time_point all_done = Clock::now();
+
+    // слияние
+    Samples sum;
+    sum.complete_us.resize(classes.size());
+    for (auto *group : {&sender_samples, &poller_samples})
+    {
+        for (Samples &s : *group)
+        {
+            sum.accept_us.insert(sum.accept_us.end(), s.accept_us.begin(), s.accept_us.end());
+            sum.poll_queue_us.insert(sum.poll_queue_us.end(), s.poll_queue_us.begin(), s.poll_queue_us.end());
+            for (size_t c = 0; c < s.complete_us.size(); ++c)
+                sum.complete_us[c].insert(sum.complete_us[c].end(), s.complete_us[c].begin(), s.complete_us[c].end());
+            sum.rejected += s.rejected;
+            sum.errors += s.errors;
+            sum.lost += s.lost;
+            sum.max_send_lag_us = std::max(sum.max_send_lag_us, s.max_send_lag_us);
+        }
+    }
+    std::vector<int64_t> complete_all;
+    for (const auto &v : sum.complete_us)
+        complete_all.insert(complete_all.end(), v.begin(), v.end());
+
+    const Percentiles accept = percentiles(sum.accept_us);
+    const Percentiles complete = percentiles(complete_all);
+    print_line("accept", accept);
+    print_line("complete", complete);
+    for (size_t c = 0; c < classes.size(); ++c)
+        print_line("complete/" + std::to_string(classes[c].bytes), percentiles(sum.complete_us[c]));
+    const Percentiles poll_queue = percentiles(sum.poll_queue_us);
+    print_line("poll_queue", poll_queue);
+    if (poll_queue.p99 >= 1.0)
+        std::printf("NOTE: ids waited for a free poller (p99 %.3fms): complete is an upper bound, raise --pollers\n",
+                    poll_queue.p99);
+
+    const double measured_s = std::max(1e-9, double(us_between(measure_from, all_done)) / 1e6);
+    const double throughput = double(complete.n) / measured_s;
+    std::printf("sent=%zu rejected=%llu errors=%llu lost=%llu completed_per_s=%.1f send_lag_max=%.3fms drain=%.3fs\n",
+                total, static_cast<unsigned long long>(sum.rejected), static_cast<unsigned long long>(sum.errors),
+                static_cast<unsigned long long>(sum.lost), throughput, double(sum.max_send_lag_us) / 1000.0,
+                double(us_between(sent_done, all_done)) / 1e6);
+
+    int rc = 0;
+    if (sum.errors > 0 || sum.lost > 0)
+    {
+        std::printf("FAIL: %llu errors, %llu lost results\n", static_cast<unsigned long long>(sum.errors),
+                    static_cast<unsigned long long>(sum.lost));
+        rc = 1;
+    }
+    if (opts.max_p99_ms > 0 && complete.p99 > opts.max_p99_ms)
+    {
+        std::printf("FAIL: complete p99 %.3fms > %.3fms\n", complete.p99, opts.max_p99_ms);
+        rc = 1;
+    }
+    if (opts.min_throughput > 0 && throughput < opts.min_throughput)
+    {
+        std::printf("FAIL: completed_per_s %.1f < %.1f\n", throughput, opts.min_throughput);
+        rc = 1;
+    }
+    return rc;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HyperLogLog: оценка числа различных элементов по 64-битным хешам в фиксированной
+// памяти -- 2^precision байт-регистров. Относительная ошибка ~1.04 / sqrt(2^precision):
+// precision 14 (16 КБ) -- около 0.8%. Малые мощности считаются linear counting.
+class HyperLogLog
+{
+public:
+    static constexpr unsigned kMinPrecision = 4;
+    static constexpr unsigned kMaxPrecision = 18;
+
+    explicit HyperLogLog(unsigned precision)
+        : p_(std::clamp(precision, kMinPrecision, kMaxPrecision)), regs_(size_t(1) << p_, 0) {}
+
+    // Наименьшая точность, при которой стандартная ошибка не больше rel_error.
+    static unsigned precision_for_error(double rel_error)
+    {
+        unsigned p = kMinPrecision;
+        while (p < kMaxPrecision && 1.04 / std::sqrt(double(size_t(1) << p)) > rel_error)
+            p++;
+        return p;
+    }
+
+    // hash может быть слабым (FNV): перед использованием он перемешивается.
+    void add(uint64_t hash)
+    {
+        const uint64_t h = mix(hash);
+        const size_t idx = static_cast<size_t>(h >> (64 - p_));
+        // ранг -- позиция первой единицы в оставшихся 64 - p битах (+1)
+        const uint64_t rest = (h << p_) | (uint64_t(1) << (p_ - 1));
+        const uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        if (rank > regs_[idx])
+            regs_[idx] = rank;
+    }
+
+    // Объединение множеств; точность должна совпадать.
+    void merge(const HyperLogLog &o)
+    {
+        for (size_t i = 0; i < regs_.size(); ++i)
+            regs_[i] = std::max(regs_[i], o.regs_[i]);
+    }
+
+    double estimate() const
+    {
+        const double m = double(regs_.size());
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (uint8_t r : regs_)
+        {
+            sum += std::ldexp(1.0, -int(r));
+            zeros += r == 0;
+        }
+        const double alpha = 0.7213 / (1.0 + 1.079 / m);
+        const double e = alpha * m * m / sum;
+        if (e <= 2.5 * m && zeros > 0)
+            return m * std::log(m / double(zeros));
+        return e;
+    }
+
+    unsigned precision() const { return p_; }
+    size_t memory_bytes() const { return regs_.size(); }
+
+private:
+    static uint64_t mix(uint64_t x)
+    {
+        // финализатор murmur3
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    unsigned p_;
+    std::vector<uint8_t> regs_;
+};
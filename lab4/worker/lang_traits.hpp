@@ -0,0 +1,146 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// Классы кодпоинтов и правила языков для ядра метрик.
+// Всё, что зависит от языка, собрано в traits-структуре; ядро -- шаблон по ней
+// и выбирается один раз на запрос (with_lang), так что во внутренних циклах
+// нет сравнений строки языка. Новый язык -- новая структура с тем же набором
+// членов плюс ветка в with_lang.
+
+// --- классы кодпоинтов (общие для всех языков: латиница + кириллица) ---
+
+enum CpClass : uint8_t
+{
+    kCpLetter = 1 << 0,
+    kCpUpper = 1 << 1,
+    kCpWord = 1 << 2, // буквы, цифры, '_' и '-'
+    kCpJunk = 1 << 3, // управляющие (кроме \t\n\r), 0x7F, ` ~ ^, zero-width, U+FFFD
+    kCpSentenceEnd = 1 << 4,
+};
+
+constexpr uint32_t kCpTableSize = 0x0480; // ASCII .. кириллица
+
+constexpr uint8_t classify_cp(uint32_t cp)
+{
+    const bool lat_upper = cp >= 'A' && cp <= 'Z';
+    const bool lat_lower = cp >= 'a' && cp <= 'z';
+    const bool cyr_upper = (cp >= 0x0410 && cp <= 0x042F) || cp == 0x0401;
+    const bool cyr_lower = (cp >= 0x0430 && cp <= 0x044F) || cp == 0x0451;
+    const bool letter = lat_upper || lat_lower || cyr_upper || cyr_lower;
+    const bool word = letter || (cp >= '0' && cp <= '9') || cp == '_' || cp == '-';
+    const bool junk = (cp < 32 && cp != '\n' && cp != '\r' && cp != '\t') || cp == 0x7F ||
+                      cp == 0xFFFD || cp == 0x200B || cp == 0x200C || cp == 0x200D ||
+                      cp == '`' || cp == '~' || cp == '^';
+    const bool sentence_end = cp == '.' || cp == '!' || cp == '?';
+
+    uint8_t c = 0;
+    if (letter)
+        c |= kCpLetter;
+    if (lat_upper || cyr_upper)
+        c |= kCpUpper;
+    if (word)
+        c |= kCpWord;
+    if (junk)
+        c |= kCpJunk;
+    if (sentence_end)
+        c |= kCpSentenceEnd;
+    return c;
+}
+
+constexpr std::array<uint8_t, kCpTableSize> make_cp_table()
+{
+    std::array<uint8_t, kCpTableSize> t{};
+    for (uint32_t cp = 0; cp < kCpTableSize; ++cp)
+        t[cp] = classify_cp(cp);
+    return t;
+}
+
+inline constexpr std::array<uint8_t, kCpTableSize> kCpTable = make_cp_table();
+
+inline uint8_t cp_class(uint32_t cp)
+{
+    if (cp < kCpTableSize)
+        return kCpTable[cp];
+    return (cp == 0xFFFD || (cp >= 0x200B && cp <= 0x200D)) ? kCpJunk : 0;
+}
+
+// --- гласные: битовая маска по окну из 64 кодпоинтов [kVowelBase, kVowelBase + 64) ---
+
+constexpr uint64_t vowel_mask(uint32_t base, std::initializer_list<uint32_t> vowels)
+{
+    uint64_t m = 0;
+    for (uint32_t v : vowels)
+        m |= uint64_t(1) << (v - base);
+    return m;
+}
+
+template <class L>
+constexpr bool traits_is_vowel(uint32_t cp_lower)
+{
+    const uint32_t d = cp_lower - L::kVowelBase; // переполнение для cp < base даёт большое d
+    return d < 64 && ((L::kVowelMask >> d) & 1u);
+}
+
+struct LangRu
+{
+    static constexpr const char *kName = "ru";
+
+    // аеёиоуыэюя
+    static constexpr uint32_t kVowelBase = 0x0430;
+    static constexpr uint64_t kVowelMask =
+        vowel_mask(kVowelBase, {0x0430, 0x0435, 0x0451, 0x0438, 0x043E, 0x0443, 0x044B, 0x044D, 0x044E, 0x044F});
+    // ASCII-гласных нет: векторное ядро слоги по маске не считает
+    static constexpr bool kAsciiVowelsEn = false;
+
+    // целевые значения для readability
+    static constexpr double kTargetWordsPerSentence = 10.0;
+    static constexpr double kTargetSyllablesPerWord = 2.0;
+    static constexpr double kTargetWordLen = 6.0;
+
+    static constexpr bool is_vowel(uint32_t cp_lower) { return traits_is_vowel<LangRu>(cp_lower); }
+};
+
+struct LangEn
+{
+    static constexpr const char *kName = "en";
+
+    static constexpr uint32_t kVowelBase = 'a';
+    static constexpr uint64_t kVowelMask = vowel_mask(kVowelBase, {'a', 'e', 'i', 'o', 'u', 'y'});
+    // ASCII-гласные совпадают с маской vowel_en векторного ядра
+    static constexpr bool kAsciiVowelsEn = true;
+
+    static constexpr double kTargetWordsPerSentence = 12.0;
+    static constexpr double kTargetSyllablesPerWord = 1.5;
+    static constexpr double kTargetWordLen = 5.0;
+
+    static constexpr bool is_vowel(uint32_t cp_lower) { return traits_is_vowel<LangEn>(cp_lower); }
+};
+
+// Векторное ядро знает только английские ASCII-гласные: язык должен либо совпадать
+// с ними на ASCII, либо не иметь ASCII-гласных вовсе.
+template <class L>
+constexpr bool ascii_vowels_consistent()
+{
+    for (uint32_t c = 0; c < 128; ++c)
+    {
+        const bool en = c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u' || c == 'y';
+        if (L::is_vowel(c) != (L::kAsciiVowelsEn && en))
+            return false;
+    }
+    return true;
+}
+static_assert(ascii_vowels_consistent<LangRu>(), "LangRu: ASCII vowels");
+static_assert(ascii_vowels_consistent<LangEn>(), "LangEn: ASCII vowels");
+
+// Вызывает f(LangXx{}) для языка запроса; неизвестный язык считается по правилам en.
+template <class F>
+decltype(auto) with_lang(const std::string &lang, F &&f)
+{
+    if (lang == LangRu::kName)
+        return f(LangRu{});
+    return f(LangEn{});
+}
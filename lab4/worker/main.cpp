@@ -0,0 +1,747 @@
+#include <nlohmann/json.hpp>
+#include <librdkafka/rdkafkacpp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "kafka_headers.hpp"
+#include "metrics_cache.hpp"
+#include "text_quality.hpp"
+#include "text_quality_parallel.hpp"
+#include "text_result.hpp"
+#include "thread_pool.hpp"
+#include "wire.hpp"
+
+using json = nlohmann::json;
+
+static std::atomic<bool> g_stop{false};
+
+static void on_signal(int)
+{
+    g_stop.store(true);
+}
+
+static int64_t now_ms()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+static int64_t steady_ms()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static json metrics_to_json(const TextMetrics &m)
+{
+    return json{
+        {"length_chars", m.length_chars},
+        {"length_bytes", m.length_bytes},
+        {"word_count", m.word_count},
+        {"avg_word_len", m.avg_word_len},
+        {"unique_word_pct", m.unique_word_pct},
+        {"consecutive_dup_pct", m.consecutive_dup_pct},
+        {"sentences", m.sentences},
+        {"caps_sequences", m.caps_sequences},
+        {"upper_ratio", m.upper_ratio},
+        {"exclam_runs", m.exclam_runs},
+        {"quest_runs", m.quest_runs},
+        {"long_space_runs", m.long_space_runs},
+        {"junk_chars", m.junk_chars},
+        {"readability", m.readability}};
+}
+
+// Считает счётчики доставки результатов (колбэк вызывается из producer->poll()).
+// Для сообщений текущего батча ведёт ещё и состояние по индексу: msg_opaque несёт
+// (поколение батча << 32) | (индекс + 1), поэтому запоздавшие отчёты о доставке
+// сообщений прошлых батчей (после таймаута ожидания) ничего не портят.
+class DeliveryCounter : public RdKafka::DeliveryReportCb
+{
+public:
+    enum State : uint8_t
+    {
+        kSkipped,
+        kInFlight,
+        kDelivered,
+        kFailed
+    };
+
+    static_assert(sizeof(void *) >= sizeof(uint64_t), "msg_opaque carries a 64-bit tag");
+
+    void dr_cb(RdKafka::Message &message) override
+    {
+        const bool ok = message.err() == RdKafka::ERR_NO_ERROR;
+        if (!ok)
+        {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[worker] delivery failed: " << message.errstr() << "\n";
+        }
+        const uint64_t tag = reinterpret_cast<uintptr_t>(message.msg_opaque());
+        const uint64_t k = (tag & 0xFFFFFFFFu) - 1;
+        if (tag != 0 && (tag >> 32) == gen_ && k < state.size())
+            state[k] = ok ? kDelivered : kFailed;
+        pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void begin_batch(size_t n)
+    {
+        state.assign(n, kSkipped);
+        ++gen_;
+    }
+
+    void *tag(size_t k) const { return reinterpret_cast<void *>(static_cast<uintptr_t>((gen_ << 32) | (k + 1))); }
+
+    std::atomic<int64_t> pending{0};
+    std::atomic<int64_t> failed{0};
+    std::vector<State> state; // по индексам текущего батча; трогает только основной поток
+
+private:
+    uint64_t gen_ = 0;
+};
+
+// Повторы недоставленных результатов: после max_attempts попыток сообщение-запрос
+// пропускается (и, если задан dead_letter_topic, копируется туда как есть).
+struct RetryOptions
+{
+    int max_attempts = 5;
+    std::string dead_letter_topic; // пусто -- только лог
+};
+
+class WorkerApp
+{
+public:
+    WorkerApp(std::string brokers,
+              std::string req_topic,
+              std::string res_topic,
+              std::string group_id,
+              int poll_ms,
+              size_t threads,
+              size_t batch_size,
+              size_t cache_bytes,
+              size_t parallel_min_bytes,
+              MetricsOptions metrics_opts,
+              RetryOptions retry_opts)
+        : brokers_(std::move(brokers)),
+          req_topic_(std::move(req_topic)),
+          res_topic_(std::move(res_topic)),
+          group_id_(std::move(group_id)),
+          poll_ms_(poll_ms),
+          threads_(threads),
+          batch_size_(batch_size),
+          parallel_min_bytes_(parallel_min_bytes),
+          metrics_opts_(metrics_opts),
+          retry_opts_(std::move(retry_opts)),
+          // вызывающий поток участвует в parallel_for, поэтому пулу нужен threads-1
+          pool_(threads > 0 ? threads - 1 : 0)
+    {
+        if (cache_bytes > 0)
+            cache_ = std::make_unique<MetricsCache>(cache_bytes, threads * 4);
+    }
+
+    bool init_kafka()
+    {
+        std::string errstr;
+
+        // Producer (results)
+        {
+            std::unique_ptr<RdKafka::Conf> conf(RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
+            if (!conf)
+            {
+                std::cerr << "[worker] Failed to create producer conf\n";
+                return false;
+            }
+
+            if (conf->set("bootstrap.servers", brokers_, errstr) != RdKafka::Conf::CONF_OK)
+            {
+                std::cerr << "[worker] producer conf error: " << errstr << "\n";
+                return false;
+            }
+            conf->set("client.id", "worker", errstr);
+            conf->set("queue.buffering.max.ms", "5", errstr);
+            if (conf->set("dr_cb", &delivery_, errstr) != RdKafka::Conf::CONF_OK)
+            {
+                std::cerr << "[worker] producer conf error: " << errstr << "\n";
+                return false;
+            }
+
+            producer_.reset(RdKafka::Producer::create(conf.get(), errstr));
+            if (!producer_)
+            {
+                std::cerr << "[worker] Failed to create producer: " << errstr << "\n";
+                return false;
+            }
+        }
+
+        // Consumer (requests)
+        {
+            std::unique_ptr<RdKafka::Conf> conf(RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
+            if (!conf)
+            {
+                std::cerr << "[worker] Failed to create consumer conf\n";
+                return false;
+            }
+
+            if (conf->set("bootstrap.servers", brokers_, errstr) != RdKafka::Conf::CONF_OK)
+            {
+                std::cerr << "[worker] consumer conf error: " << errstr << "\n";
+                return false;
+            }
+            conf->set("group.id", group_id_, errstr);
+            conf->set("enable.auto.commit", "false", errstr);
+            conf->set("auto.offset.reset", "earliest", errstr);
+
+            consumer_.reset(RdKafka::KafkaConsumer::create(conf.get(), errstr));
+            if (!consumer_)
+            {
+                std::cerr << "[worker] Failed to create consumer: " << errstr << "\n";
+                return false;
+            }
+
+            auto err = consumer_->subscribe({req_topic_});
+            if (err)
+            {
+                std::cerr << "[worker] subscribe error: " << RdKafka::err2str(err) << "\n";
+                return false;
+            }
+        }
+
+        std::cout << "[worker] Kafka initialized. brokers=" << brokers_
+                  << " req_topic=" << req_topic_ << " res_topic=" << res_topic_
+                  << " group=" << group_id_ << " threads=" << threads_
+                  << " batch=" << batch_size_ << " hll_threshold=" << metrics_opts_.hll_threshold_words
+                  << " max_attempts=" << retry_opts_.max_attempts
+                  << " dead_letter=" << (retry_opts_.dead_letter_topic.empty() ? "-" : retry_opts_.dead_letter_topic) << "\n";
+        return true;
+    }
+
+    void run()
+    {
+        std::vector<std::unique_ptr<RdKafka::Message>> batch;
+        std::vector<Reply> results;
+        batch.reserve(batch_size_);
+
+        stats_start_ms_ = steady_ms();
+        stats_start_cpu_ = std::clock();
+
+        while (!g_stop.load())
+        {
+            collect_batch(batch);
+            if (!batch.empty())
+            {
+                results.assign(batch.size(), Reply{});
+                parallel_for(pool_, batch.size(), [&](size_t k)
+                             { results[k] = process_message(*batch[k]); });
+
+                produce_results(batch, results);
+                if (settle_batch(batch))
+                {
+                    // коммит один раз на батч: позиции уже сдвинуты consume()
+                    consumer_->commitAsync();
+                    stats_msgs_ += static_cast<int64_t>(batch.size());
+                    stats_batches_++;
+                }
+                else
+                {
+                    producer_->poll(100); // пауза перед повтором
+                }
+            }
+            producer_->poll(0);
+            report_stats();
+        }
+    }
+
+    void stop()
+    {
+        std::cout << "[worker] Shutting down...\n";
+
+        if (consumer_)
+        {
+            consumer_->commitSync();
+            consumer_->close();
+        }
+        if (producer_)
+        {
+            producer_->flush(5000);
+        }
+
+        consumer_.reset();
+        producer_.reset();
+
+        RdKafka::wait_destroyed(5000);
+        std::cout << "[worker] Stopped.\n";
+    }
+
+private:
+    // Первое сообщение ждём poll_ms_, остальные забираем без ожидания до batch_size_.
+    void collect_batch(std::vector<std::unique_ptr<RdKafka::Message>> &batch)
+    {
+        batch.clear();
+        int timeout = poll_ms_;
+        while (batch.size() < batch_size_)
+        {
+            std::unique_ptr<RdKafka::Message> msg(consumer_->consume(timeout));
+            if (!msg)
+                break;
+
+            if (msg->err() == RdKafka::ERR_NO_ERROR)
+            {
+                batch.push_back(std::move(msg));
+                timeout = 0;
+            }
+            else if (msg->err() == RdKafka::ERR__TIMED_OUT)
+            {
+                break;
+            }
+            else if (msg->err() == RdKafka::ERR__PARTITION_EOF)
+            {
+                // ignore
+            }
+            else
+            {
+                std::cerr << "[worker] consumer error: " << msg->errstr() << "\n";
+                break;
+            }
+        }
+    }
+
+    // Ответ на сообщение батча; пустой payload -- сообщение пропускается.
+    struct Reply
+    {
+        std::string payload;
+        bool binary = false;
+    };
+
+    // Выполняется в потоках пула. Формат запроса -- по заголовку tq-format,
+    // формат ответа -- по tq-accept (см. wire.hpp).
+    Reply process_message(RdKafka::Message &msg)
+    {
+        RdKafka::Headers *headers = msg.headers();
+        const bool reply_binary = kafka_header_is(headers, wire::kHeaderAccept, wire::kBinaryV1);
+        const char *data = static_cast<const char *>(msg.payload());
+
+        if (kafka_header_is(headers, wire::kHeaderFormat, wire::kBinaryV1))
+        {
+            // текст читается прямо из payload сообщения, без копирования
+            wire::Request req;
+            if (!wire::decode_request(data, msg.len(), req) || req.request_id.empty())
+            {
+                std::cerr << "[worker] invalid binary request message\n";
+                return Reply{};
+            }
+            const std::string lang = req.language.empty() ? std::string("ru") : std::string(req.language);
+            return make_reply(req.request_id, req.timestamp, lang, req.text, reply_binary);
+        }
+
+        try
+        {
+            auto j = json::parse(data, data + msg.len());
+
+            if (!j.contains("request_id") || !j["request_id"].is_string())
+            {
+                std::cerr << "[worker] invalid request message (no request_id)\n";
+                return Reply{};
+            }
+
+            std::string lang = "ru";
+            if (j.contains("language") && j["language"].is_string())
+                lang = j["language"].get<std::string>();
+
+            std::optional<std::string_view> text;
+            if (j.contains("text") && j["text"].is_string())
+                text = j["text"].get_ref<const std::string &>();
+
+            return make_reply(j["request_id"].get_ref<const std::string &>(),
+                              j.value("timestamp", int64_t{0}), lang, text, reply_binary);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[worker] parse request error: " << e.what() << "\n";
+            return Reply{};
+        }
+    }
+
+    // Метрики, оценка и сериализация результата. Без текста -- ошибка invalid_request.
+    Reply make_reply(std::string_view request_id, int64_t timestamp, const std::string &lang,
+                     std::optional<std::string_view> text, bool binary)
+    {
+        std::vector<std::string> errors;
+        int score = 0;
+        TextMetrics m;
+        if (text)
+        {
+            if (!cache_)
+            {
+                m = compute_text(*text, lang);
+            }
+            else
+            {
+                const Hash128 key = MetricsCache::key_for(*text, lang);
+                if (!cache_->get(key, m))
+                {
+                    m = compute_text(*text, lang);
+                    cache_->put(key, m);
+                }
+            }
+            score = compute_score(m, lang, errors);
+        }
+        else
+        {
+            errors.push_back("invalid_request");
+        }
+        const std::string status = status_from_score(score, errors);
+
+        Reply reply;
+        reply.binary = binary;
+        if (binary)
+        {
+            wire::Result r;
+            r.request_id = request_id;
+            r.timestamp = timestamp;
+            r.processed_ms = now_ms();
+            r.language = lang;
+            r.score = score;
+            r.status = status;
+            r.errors.assign(errors.begin(), errors.end());
+            r.has_metrics = text.has_value();
+            if (text)
+                r.metrics = metrics_to_wire(m);
+            wire::encode_result(r, reply.payload);
+        }
+        else
+        {
+            json out = {
+                {"request_id", request_id},
+                {"timestamp", timestamp},
+                {"processed_ms", now_ms()},
+                {"language", lang},
+                {"score", score},
+                {"status", status},
+                {"errors", errors},
+                {"metrics", text ? metrics_to_json(m) : json::object()}};
+            reply.payload = out.dump();
+        }
+        return reply;
+    }
+
+    // Большие тексты делятся на куски и считаются всем пулом: вложенный parallel_for
+    // из задачи батча безопасен, ожидающий поток сам выполняет задачи очереди.
+    TextMetrics compute_text(std::string_view text, const std::string &lang)
+    {
+        if (parallel_min_bytes_ > 0 && text.size() >= parallel_min_bytes_ && pool_.size() > 0)
+        {
+            ParallelMetricsOptions opts;
+            opts.metrics = metrics_opts_;
+            return compute_metrics_parallel(text.data(), text.size(), lang, pool_, opts);
+        }
+        return compute_metrics(text.data(), text.size(), lang, metrics_opts_);
+    }
+
+    // Отправляет результаты батча и ждёт отчётов о доставке; итог по каждому
+    // сообщению -- в delivery_.state (не подтверждённые к дедлайну -- kFailed).
+    void produce_results(const std::vector<std::unique_ptr<RdKafka::Message>> &batch,
+                         std::vector<Reply> &results)
+    {
+        delivery_.begin_batch(batch.size());
+        for (size_t k = 0; k < results.size(); ++k)
+        {
+            std::string &payload = results[k].payload;
+            if (payload.empty() || gave_up(*batch[k]))
+                continue;
+
+            const std::string *key = batch[k]->key();
+            // заголовки, как и payload, librdkafka забирает только при успешном produce
+            RdKafka::Headers *headers = nullptr;
+            if (results[k].binary)
+            {
+                headers = RdKafka::Headers::create();
+                headers->add(wire::kHeaderFormat, wire::kBinaryV1.data(), wire::kBinaryV1.size());
+            }
+            while (true)
+            {
+                delivery_.pending.fetch_add(1, std::memory_order_relaxed);
+                auto err = producer_->produce(
+                    res_topic_,
+                    RdKafka::Topic::PARTITION_UA,
+                    RdKafka::Producer::RK_MSG_COPY,
+                    payload.data(),
+                    payload.size(),
+                    key ? key->data() : nullptr,
+                    key ? key->size() : 0,
+                    0,
+                    headers,
+                    delivery_.tag(k));
+                if (err == RdKafka::ERR_NO_ERROR)
+                {
+                    delivery_.state[k] = DeliveryCounter::kInFlight;
+                    break;
+                }
+
+                delivery_.pending.fetch_sub(1, std::memory_order_relaxed);
+                if (err != RdKafka::ERR__QUEUE_FULL)
+                {
+                    delete headers;
+                    std::cerr << "[worker] produce error: " << RdKafka::err2str(err) << "\n";
+                    delivery_.failed.fetch_add(1, std::memory_order_relaxed);
+                    delivery_.state[k] = DeliveryCounter::kFailed;
+                    break;
+                }
+                producer_->poll(100); // очередь librdkafka полна: ждём доставки
+            }
+        }
+
+        // Не коммитим батч, пока его результаты не подтверждены брокером.
+        int64_t deadline = steady_ms() + 30000;
+        while (delivery_.pending.load(std::memory_order_relaxed) > 0 && steady_ms() < deadline)
+            producer_->poll(10);
+
+        for (auto &st : delivery_.state)
+        {
+            if (st == DeliveryCounter::kInFlight)
+                st = DeliveryCounter::kFailed;
+        }
+    }
+
+    // Разбирает итог доставки батча. Недоставленное сообщение получает ещё одну
+    // попытку; исчерпавшее лимит пропускается (dead letter). Партиции с сообщениями,
+    // которые ещё будут повторяться, возвращаются к первому такому смещению --
+    // доставленные после него результаты уйдут повторно, gateway принимает их
+    // идемпотентно. true -- повторять нечего, батч можно коммитить.
+    bool settle_batch(const std::vector<std::unique_ptr<RdKafka::Message>> &batch)
+    {
+        std::map<int32_t, int64_t> rewind; // партиция -> первое смещение для повтора
+        std::map<int32_t, int64_t> last;   // партиция -> последнее смещение батча
+        for (size_t k = 0; k < batch.size(); ++k)
+        {
+            RdKafka::Message &msg = *batch[k];
+            last[msg.partition()] = msg.offset();
+            if (delivery_.state[k] != DeliveryCounter::kFailed)
+                continue;
+            int &attempts = attempts_[{msg.partition(), msg.offset()}];
+            if (++attempts >= retry_opts_.max_attempts)
+            {
+                dead_letter(msg, attempts);
+                continue;
+            }
+            rewind.emplace(msg.partition(), msg.offset()); // первое по порядку батча
+        }
+
+        if (rewind.empty())
+        {
+            // смещения до конца батча больше не читаются: их счётчики попыток не нужны
+            for (const auto &pl : last)
+                attempts_.erase(attempts_.lower_bound({pl.first, 0}), attempts_.upper_bound({pl.first, pl.second}));
+            return true;
+        }
+
+        const std::string &topic = batch.front()->topic_name();
+        for (const auto &pr : rewind)
+        {
+            std::unique_ptr<RdKafka::TopicPartition> tp(RdKafka::TopicPartition::create(topic, pr.first, pr.second));
+            auto err = consumer_->seek(*tp, 1000);
+            std::cerr << "[worker] undelivered results, partition=" << pr.first
+                      << " rewound to offset=" << pr.second;
+            if (err)
+                std::cerr << " seek error: " << RdKafka::err2str(err);
+            std::cerr << "\n";
+        }
+        return false;
+    }
+
+    bool gave_up(const RdKafka::Message &msg) const
+    {
+        auto it = attempts_.find({msg.partition(), msg.offset()});
+        return it != attempts_.end() && it->second >= retry_opts_.max_attempts;
+    }
+
+    // Запрос, результат которого так и не удалось доставить: в лог и, если задан,
+    // в dead letter topic (payload, ключ и заголовки исходного сообщения).
+    void dead_letter(RdKafka::Message &msg, int attempts)
+    {
+        std::cerr << "[worker] giving up on request partition=" << msg.partition()
+                  << " offset=" << msg.offset() << " after " << attempts << " attempts";
+        if (retry_opts_.dead_letter_topic.empty())
+        {
+            std::cerr << ", skipped\n";
+            return;
+        }
+        std::cerr << ", sent to " << retry_opts_.dead_letter_topic << "\n";
+
+        const std::string *key = msg.key();
+        RdKafka::Headers *src = msg.headers();
+        RdKafka::Headers *headers = src ? RdKafka::Headers::create(src->get_all()) : nullptr;
+        delivery_.pending.fetch_add(1, std::memory_order_relaxed);
+        auto err = producer_->produce(
+            retry_opts_.dead_letter_topic,
+            RdKafka::Topic::PARTITION_UA,
+            RdKafka::Producer::RK_MSG_COPY,
+            msg.payload(),
+            msg.len(),
+            key ? key->data() : nullptr,
+            key ? key->size() : 0,
+            0,
+            headers,
+            nullptr);
+        if (err != RdKafka::ERR_NO_ERROR)
+        {
+            delivery_.pending.fetch_sub(1, std::memory_order_relaxed);
+            delete headers;
+            std::cerr << "[worker] dead letter produce error: " << RdKafka::err2str(err) << "\n";
+        }
+    }
+
+    void report_stats()
+    {
+        int64_t t = steady_ms();
+        int64_t elapsed = t - stats_start_ms_;
+        if (elapsed < 5000)
+            return;
+
+        std::clock_t cpu = std::clock();
+        double cpu_s = double(cpu - stats_start_cpu_) / CLOCKS_PER_SEC;
+        double wall_s = double(elapsed) / 1000.0;
+        double rate = double(stats_msgs_) / wall_s;
+
+        if (stats_msgs_ > 0)
+        {
+            std::cout << "[worker] stats msgs=" << stats_msgs_
+                      << " batches=" << stats_batches_
+                      << " avg_batch=" << double(stats_msgs_) / double(std::max<int64_t>(1, stats_batches_))
+                      << " msg_per_s=" << rate
+                      << " msg_per_s_per_thread=" << rate / double(threads_)
+                      << " msg_per_cpu_s=" << (cpu_s > 0.0 ? double(stats_msgs_) / cpu_s : 0.0)
+                      << " delivery_failed=" << delivery_.failed.load(std::memory_order_relaxed);
+            if (cache_)
+            {
+                MetricsCache::Stats cs = cache_->stats();
+                uint64_t lookups = cs.hits + cs.misses;
+                std::cout << " cache_hit_pct=" << (lookups ? 100.0 * double(cs.hits) / double(lookups) : 0.0)
+                          << " cache_hits=" << cs.hits
+                          << " cache_evictions=" << cs.evictions;
+            }
+            std::cout << "\n";
+        }
+
+        stats_start_ms_ = t;
+        stats_start_cpu_ = cpu;
+        stats_msgs_ = 0;
+        stats_batches_ = 0;
+    }
+
+private:
+    std::string brokers_;
+    std::string req_topic_;
+    std::string res_topic_;
+    std::string group_id_;
+    int poll_ms_;
+    size_t threads_;
+    size_t batch_size_;
+    size_t parallel_min_bytes_; // 0 -- всегда последовательно
+    const MetricsOptions metrics_opts_;
+    const RetryOptions retry_opts_;
+
+    ThreadPool pool_;
+    DeliveryCounter delivery_;
+    std::unique_ptr<MetricsCache> cache_; // nullptr -- кэш выключен (WORKER_CACHE_MB=0)
+
+    std::unique_ptr<RdKafka::Producer> producer_;
+    std::unique_ptr<RdKafka::KafkaConsumer> consumer_;
+
+    // (партиция, смещение) -> неудачные попытки доставки результата
+    std::map<std::pair<int32_t, int64_t>, int> attempts_;
+
+    int64_t stats_start_ms_ = 0;
+    std::clock_t stats_start_cpu_ = 0;
+    int64_t stats_msgs_ = 0;
+    int64_t stats_batches_ = 0;
+};
+
+static std::string getenv_or(const char *k, const std::string &defv)
+{
+    const char *v = std::getenv(k);
+    return v ? std::string(v) : defv;
+}
+
+static int getenv_int_or(const char *k, int defv)
+{
+    const char *v = std::getenv(k);
+    if (!v)
+        return defv;
+    try
+    {
+        return std::stoi(v);
+    }
+    catch (...)
+    {
+        return defv;
+    }
+}
+
+static double getenv_double_or(const char *k, double defv)
+{
+    const char *v = std::getenv(k);
+    if (!v)
+        return defv;
+    try
+    {
+        return std::stod(v);
+    }
+    catch (...)
+    {
+        return defv;
+    }
+}
+
+int main()
+{
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    std::string brokers = getenv_or("KAFKA_BOOTSTRAP_SERVERS", "kafka:9092");
+    std::string req_topic = getenv_or("KAFKA_REQUEST_TOPIC", "text_requests");
+    std::string res_topic = getenv_or("KAFKA_RESULT_TOPIC", "text_results");
+    std::string group_id = getenv_or("KAFKA_GROUP_ID", "text_quality_workers");
+    int poll_ms = getenv_int_or("WORKER_POLL_MS", 250);
+    int threads = getenv_int_or("WORKER_THREADS", static_cast<int>(std::thread::hardware_concurrency()));
+    int batch_size = getenv_int_or("WORKER_BATCH_SIZE", 256);
+    int cache_mb = getenv_int_or("WORKER_CACHE_MB", 64);
+    int parallel_min_kb = getenv_int_or("WORKER_PARALLEL_MIN_KB", 1024);
+
+    MetricsOptions metrics_opts;
+    metrics_opts.hll_threshold_words = static_cast<size_t>(std::max(0, getenv_int_or("WORKER_HLL_THRESHOLD", 0)));
+    metrics_opts.hll_error = std::clamp(getenv_double_or("WORKER_HLL_ERROR", 0.01), 0.001, 0.5);
+
+    RetryOptions retry_opts;
+    retry_opts.max_attempts = std::max(1, getenv_int_or("WORKER_MAX_ATTEMPTS", 5));
+    retry_opts.dead_letter_topic = getenv_or("WORKER_DEAD_LETTER_TOPIC", "");
+
+    WorkerApp app(brokers, req_topic, res_topic, group_id, poll_ms,
+                  static_cast<size_t>(std::max(1, threads)),
+                  static_cast<size_t>(std::max(1, batch_size)),
+                  static_cast<size_t>(std::max(0, cache_mb)) << 20,
+                  static_cast<size_t>(std::max(0, parallel_min_kb)) << 10,
+                  metrics_opts,
+                  retry_opts);
+
+    if (!app.init_kafka())
+    {
+        std::cerr << "[worker] init failed\n";
+        return 1;
+    }
+
+    app.run();
+    app.stop();
+    return 0;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hash128.hpp"
+#include "text_quality.hpp"
+
+// Кэш метрик по содержимому: ключ -- hash128(text) с seed от языка.
+// Хранится только TextMetrics: compute_score/status_from_score от него дешёвые
+// и детерминированные, поэтому пересчитываются на каждый ответ.
+//
+// Вытеснение -- CLOCK: у записи бит обращения, стрелка идёт по кольцу записей шарда
+// и освобождает первую запись со сброшенным битом. Ёмкость фиксируется по лимиту
+// памяти при создании, после заполнения новые записи занимают места вытесненных.
+class MetricsCache
+{
+public:
+    // Оценка памяти на запись: сама запись + узел и корзина unordered_map.
+    static constexpr size_t kBytesPerEntry = 96 + sizeof(TextMetrics) + 16 + 8;
+
+    MetricsCache(size_t max_bytes, size_t shards)
+    {
+        size_t n = 1;
+        while (n < shards)
+            n <<= 1;
+        shard_mask_ = n - 1;
+        shards_.reset(new Shard[n]);
+        const size_t per_shard = std::max<size_t>(1, max_bytes / kBytesPerEntry / n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            shards_[i].capacity = per_shard;
+            shards_[i].entries.reserve(per_shard);
+            shards_[i].index.reserve(per_shard);
+        }
+        capacity_ = per_shard * n;
+    }
+
+    static Hash128 key_for(std::string_view text, std::string_view lang)
+    {
+        return hash128(text, hash128(lang).lo);
+    }
+
+    bool get(const Hash128 &key, TextMetrics &out)
+    {
+        Shard &sh = shard_for(key);
+        {
+            std::lock_guard<std::mutex> lk(sh.mtx);
+            auto it = sh.index.find(key);
+            if (it != sh.index.end())
+            {
+                Entry &e = sh.entries[it->second];
+                e.referenced = true;
+                out = e.metrics;
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void put(const Hash128 &key, const TextMetrics &m)
+    {
+        Shard &sh = shard_for(key);
+        std::lock_guard<std::mutex> lk(sh.mtx);
+        auto it = sh.index.find(key);
+        if (it != sh.index.end())
+        {
+            // параллельный промах по тому же тексту: значение то же самое
+            sh.entries[it->second].referenced = true;
+            return;
+        }
+
+        uint32_t slot;
+        if (sh.entries.size() < sh.capacity)
+        {
+            slot = static_cast<uint32_t>(sh.entries.size());
+            sh.entries.push_back(Entry{});
+        }
+        else
+        {
+            slot = sh.evict_one();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        Entry &e = sh.entries[slot];
+        e.key = key;
+        e.metrics = m;
+        e.referenced = false; // вторая попытка нужна только записям, к которым обращались
+        sh.index.emplace(key, slot);
+        inserts_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;
+    };
+
+    Stats stats() const
+    {
+        Stats s;
+        s.hits = hits_.load(std::memory_order_relaxed);
+        s.misses = misses_.load(std::memory_order_relaxed);
+        s.inserts = inserts_.load(std::memory_order_relaxed);
+        s.evictions = evictions_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry
+    {
+        Hash128 key;
+        TextMetrics metrics;
+        bool referenced = false;
+    };
+
+    struct alignas(64) Shard
+    {
+        std::mutex mtx;
+        std::vector<Entry> entries;
+        std::unordered_map<Hash128, uint32_t, Hash128Hasher> index;
+        size_t capacity = 0;
+        size_t hand = 0;
+
+        // CLOCK: сбрасывает биты обращения, пока не найдёт запись без него
+        uint32_t evict_one()
+        {
+            while (true)
+            {
+                Entry &e = entries[hand];
+                const uint32_t slot = static_cast<uint32_t>(hand);
+                hand = hand + 1 == entries.size() ? 0 : hand + 1;
+                if (e.referenced)
+                {
+                    e.referenced = false;
+                    continue;
+                }
+                index.erase(e.key);
+                return slot;
+            }
+        }
+    };
+
+    Shard &shard_for(const Hash128 &key) const
+    {
+        return shards_[static_cast<size_t>(key.hi) & shard_mask_];
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_mask_ = 0;
+    size_t capacity_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> inserts_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
@@ -1,11 +1,18 @@
 #pragma once
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
 
+#include "hll.hpp"
+#include "lang_traits.hpp"
+#include "text_quality_simd.hpp"
+
 struct TextMetrics
 {
     int64_t length_chars = 0; // число UTF-8 кодпоинтов (упрощённо, без grapheme clusters)
@@ -27,10 +34,19 @@ struct TextMetrics
     double readability = 0.0; // 0..100 (эвристика)
 };
 
+struct MetricsOptions
+{
+    // Уникальные слова считаются точно, пока различных слов не больше hll_threshold_words,
+    // дальше -- оценкой HyperLogLog с относительной ошибкой ~hll_error (память на запрос
+    // ограничена порогом). 0 -- всегда точно.
+    size_t hll_threshold_words = 0;
+    double hll_error = 0.01;
+};
+
 // --- UTF-8 decode (минимально безопасный) ---
-inline bool utf8_next(const std::string &s, size_t &i, uint32_t &cp)
+inline bool utf8_next(const char *s, size_t n, size_t &i, uint32_t &cp)
 {
-    if (i >= s.size())
+    if (i >= n)
         return false;
     unsigned char c = static_cast<unsigned char>(s[i]);
     if (c < 0x80)
@@ -54,10 +70,10 @@ inline bool utf8_next(const std::string &s, size_t &i, uint32_t &cp)
         return true;
     }
 
-    if (i + len > s.size())
+    if (i + len > n)
     {
         cp = 0xFFFD;
-        i = s.size();
+        i = n;
         return true;
     }
 
@@ -78,6 +94,11 @@ inline bool utf8_next(const std::string &s, size_t &i, uint32_t &cp)
     return true;
 }
 
+inline bool utf8_next(const std::string &s, size_t &i, uint32_t &cp)
+{
+    return utf8_next(s.data(), s.size(), i, cp);
+}
+
 inline bool is_cyr_upper(uint32_t cp) { return (cp >= 0x0410 && cp <= 0x042F) || cp == 0x0401; }
 inline bool is_cyr_lower(uint32_t cp) { return (cp >= 0x0430 && cp <= 0x044F) || cp == 0x0451; }
 inline bool is_lat_upper(uint32_t cp) { return (cp >= 'A' && cp <= 'Z'); }
@@ -119,19 +140,8 @@ inline bool is_sentence_end(uint32_t cp)
     return cp == '.' || cp == '!' || cp == '?';
 }
 
-inline bool is_vowel_ru(uint32_t cp_lower)
-{
-    // аеёиоуыэюя
-    static const uint32_t v[] = {0x0430, 0x0435, 0x0451, 0x0438, 0x043E, 0x0443, 0x044B, 0x044D, 0x044E, 0x044F};
-    for (auto x : v)
-        if (cp_lower == x)
-            return true;
-    return false;
-}
-inline bool is_vowel_en(uint32_t cp_lower)
-{
-    return cp_lower == 'a' || cp_lower == 'e' || cp_lower == 'i' || cp_lower == 'o' || cp_lower == 'u' || cp_lower == 'y';
-}
+inline bool is_vowel_ru(uint32_t cp_lower) { return LangRu::is_vowel(cp_lower); }
+inline bool is_vowel_en(uint32_t cp_lower) { return LangEn::is_vowel(cp_lower); }
 
 struct U32Hash
 {
@@ -147,14 +157,14 @@ struct U32Hash
     }
 };
 
-inline int count_vowel_groups(const std::u32string &w, const std::string &lang)
+template <class L>
+inline int count_vowel_groups(const std::u32string &w)
 {
     bool prev_v = false;
     int groups = 0;
     for (uint32_t cp : w)
     {
-        uint32_t cpl = to_lower_simple(cp);
-        bool v = (lang == "ru") ? is_vowel_ru(cpl) : is_vowel_en(cpl);
+        bool v = L::is_vowel(to_lower_simple(cp));
         if (v && !prev_v)
             groups++;
         prev_v = v;
@@ -162,195 +172,703 @@ inline int count_vowel_groups(const std::u32string &w, const std::string &lang)
     return groups;
 }
 
-inline TextMetrics compute_metrics(const std::string &text, const std::string &lang)
+inline int count_vowel_groups(const std::u32string &w, const std::string &lang)
+{
+    return with_lang(lang, [&](auto l)
+                     { return count_vowel_groups<decltype(l)>(w); });
+}
+
+inline unsigned popcount32(uint32_t x) { return static_cast<unsigned>(__builtin_popcount(x)); }
+inline unsigned ctz32(uint32_t x) { return static_cast<unsigned>(__builtin_ctz(x)); } // x != 0
+
+// Длина серии единиц, заканчивающейся на старшем из len бит маски m;
+// carry -- длина серии до начала маски.
+inline int64_t tail_run(uint32_t m, unsigned len, int64_t carry)
+{
+    const uint32_t full = len == 32 ? ~0u : ((1u << len) - 1);
+    if (m == full)
+        return carry + len;
+    const uint32_t inv = ~m & full;
+    return static_cast<int64_t>(len - 1) - (31 - __builtin_clz(inv));
+}
+
+// Сколько серий единиц достигают длины ровно k внутри маски (с учётом carry до неё).
+template <unsigned K>
+inline unsigned count_runs_reaching(uint32_t m, int64_t carry)
 {
-    TextMetrics m;
-    m.length_bytes = static_cast<int64_t>(text.size());
+    const unsigned c = static_cast<unsigned>(std::min<int64_t>(carry, K));
+    const uint64_t ext = (uint64_t(m) << K) | (((uint64_t(1) << c) - 1) << (K - c));
+    uint64_t t = ext & ~(ext << K);
+    for (unsigned j = 1; j < K; ++j)
+        t &= ext << j;
+    return static_cast<unsigned>(__builtin_popcountll(t >> K));
+}
 
-    std::vector<std::u32string> words;
-    words.reserve(128);
+// Есть ли внутри маски серия единиц длиной >= k (с учётом carry до неё).
+template <unsigned K>
+inline bool has_run(uint32_t m, int64_t carry)
+{
+    const unsigned c = static_cast<unsigned>(std::min<int64_t>(carry, K - 1));
+    const uint64_t ext = (uint64_t(m) << (K - 1)) | (((uint64_t(1) << c) - 1) << (K - 1 - c));
+    uint64_t t = ext;
+    for (unsigned j = 1; j < K; ++j)
+        t &= ext >> j;
+    return t != 0;
+}
 
-    std::u32string cur;
-    cur.reserve(32);
+// Интернированные слова одного текста. Байты слов (в нижнем регистре, UTF-8) лежат
+// подряд в арене, таблица с открытой адресацией хранит (hash, offset, len).
+// Id слова -- смещение его первого вхождения в арене: одинаковые слова == одинаковые id.
+// clear() сохраняет ёмкость, так что повторное использование не аллоцирует.
+class WordTable
+{
+public:
+    static constexpr uint32_t kNoWord = UINT32_MAX;
+
+    void clear()
+    {
+        // таблица живёт в thread_local каждого потока пула: после большого текста
+        // арена и слоты (24 байта на слот, до 2x уникальных слов) возвращаются к начальному размеру
+        if (arena_.size() > kRetainBytes)
+            std::vector<char>().swap(arena_);
+        if (slots_.size() * sizeof(Slot) > kRetainBytes)
+        {
+            std::vector<Slot>().swap(slots_);
+            shift_ = 64;
+        }
+        arena_len_ = 0;
+        word_begin_ = 0;
+        used_ = 0;
+        if (++gen_ == 0)
+        {
+            // переполнение поколения: честно чистим слоты
+            std::fill(slots_.begin(), slots_.end(), Slot{});
+            gen_ = 1;
+        }
+    }
 
-    int64_t letters = 0;
-    int64_t uppers = 0;
-    int64_t max_upper_run = 0;
-    int64_t current_upper_run = 0;
+    // Текущее (незавершённое) слово дописывается в хвост арены.
+    // Арена растёт вручную (arena_len_ <= arena_.size()): vector::insert на каждый отрезок
+    // слова компилятор не всегда встраивает, а это самый частый вызов сканера.
+    void push_byte(char c)
+    {
+        if (arena_len_ == arena_.size())
+            grow_arena(1);
+        arena_[arena_len_++] = c;
+    }
+    void push_bytes(const unsigned char *p, size_t n)
+    {
+        if (arena_.size() - arena_len_ < n)
+            grow_arena(n);
+        std::memcpy(arena_.data() + arena_len_, p, n);
+        arena_len_ += n;
+    }
 
-    int64_t syllables = 0;
-    int64_t sentences = 0;
+    // Завершает слово из хвоста арены. Новое слово остаётся в арене,
+    // повтор откатывает хвост и возвращает id первого вхождения.
+    // Новое слово при заполненной таблице (limit) не сохраняется -- kNoWord.
+    uint32_t intern(uint64_t hash)
+    {
+        const uint32_t off = static_cast<uint32_t>(word_begin_);
+        const uint32_t len = static_cast<uint32_t>(arena_len_ - word_begin_);
 
-    int64_t exclam_run = 0;
-    int64_t quest_run = 0;
-    int64_t space_run = 0;
+        if ((used_ + 1) * 2 > slots_.size())
+            grow();
 
-    size_t i = 0;
-    uint32_t cp = 0;
-    uint32_t prev_cp = 0;
-    bool prev_sentence_end = false;
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = index_of(hash);; i = (i + 1) & mask)
+        {
+            Slot &s = slots_[i];
+            if (s.gen != gen_)
+            {
+                if (used_ >= limit_)
+                {
+                    arena_len_ = word_begin_;
+                    return kNoWord;
+                }
+                s = Slot{hash, off, len, gen_};
+                used_++;
+                word_begin_ = arena_len_;
+                return off;
+            }
+            if (s.hash == hash && s.len == len &&
+                std::memcmp(arena_.data() + s.off, arena_.data() + off, len) == 0)
+            {
+                arena_len_ = word_begin_;
+                return s.off;
+            }
+        }
+    }
+
+    size_t unique_count() const { return used_; }
+
+    // Максимум различных слов (по умолчанию без ограничения).
+    void set_limit(size_t limit) { limit_ = limit; }
+
+    // f(hash, bytes, len) для каждого уникального слова; указатели живут до clear()
+    template <class F>
+    void for_each_word(F &&f) const
+    {
+        for (const Slot &s : slots_)
+            if (s.gen == gen_)
+                f(s.hash, arena_.data() + s.off, static_cast<size_t>(s.len));
+    }
+
+    // Байты слова по id (и его хешу, чтобы найти слот)
+    std::string_view word(uint64_t hash, uint32_t id) const
+    {
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = index_of(hash);; i = (i + 1) & mask)
+        {
+            const Slot &s = slots_[i];
+            if (s.gen == gen_ && s.off == id)
+                return std::string_view(arena_.data() + s.off, s.len);
+        }
+    }
+
+private:
+    static constexpr size_t kRetainBytes = size_t(4) << 20;
+
+    struct Slot
+    {
+        uint64_t hash = 0;
+        uint32_t off = 0;
+        uint32_t len = 0;
+        uint32_t gen = 0;
+    };
+
+    size_t index_of(uint64_t hash) const
+    {
+        // multiplicative hashing: FNV плохо перемешивает младшие биты
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
 
-    while (utf8_next(text, i, cp))
+    void grow_arena(size_t need)
     {
-        m.length_chars++;
+        arena_.resize(std::max(arena_.size() * 2, std::max<size_t>(arena_len_ + need, 4096)));
+    }
 
-        // junk chars (controls, zero-width, replacement)
-        if ((cp < 32 && cp != '\n' && cp != '\r' && cp != '\t') ||
-            cp == 0x7F || cp == 0xFFFD || cp == 0x200B || cp == 0x200C || cp == 0x200D)
+    void grow()
+    {
+        size_t n = slots_.empty() ? 256 : slots_.size() * 2;
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(n, Slot{});
+        shift_ = 64;
+        for (size_t k = n; k > 1; k >>= 1)
+            shift_--;
+
+        const size_t mask = n - 1;
+        for (const Slot &s : old)
         {
-            m.junk_chars++;
+            if (s.gen != gen_)
+                continue;
+            size_t i = index_of(s.hash);
+            while (slots_[i].gen == gen_)
+                i = (i + 1) & mask;
+            slots_[i] = s;
         }
-        // "мусорные" ascii
-        if (cp == '`' || cp == '~' || cp == '^')
-            m.junk_chars++;
+    }
+
+    std::vector<char> arena_;
+    size_t arena_len_ = 0;
+    std::vector<Slot> slots_;
+    size_t word_begin_ = 0;
+    size_t used_ = 0;
+    size_t limit_ = SIZE_MAX;
+    uint32_t gen_ = 1;
+    unsigned shift_ = 64;
+};
+
+// Однопроходный подсчёт метрик: кодпоинты подаются по одному через push(),
+// слова не копируются -- они хешируются по мере чтения и интернируются в WordTable.
+// Уникальные слова, повторы подряд и слоги считаются в том же проходе.
+// Lang -- traits языка (lang_traits.hpp).
+template <class Lang>
+class BasicMetricsScanner
+{
+public:
+    explicit BasicMetricsScanner(WordTable &table, const MetricsOptions &opts = {})
+        : table_(table), sketch_error_(opts.hll_error)
+    {
+        table_.set_limit(opts.hll_threshold_words > 0 ? opts.hll_threshold_words : SIZE_MAX);
+    }
+
+    void push(uint32_t cp)
+    {
+        m_.length_chars++;
+        const uint8_t cls = cp_class(cp);
+
+        // junk chars (controls, zero-width, replacement) и "мусорные" ascii
+        if (cls & kCpJunk)
+            m_.junk_chars++;
 
         // sentence count by groups of .!? (не считаем "!!!" как 3 предложения)
-        if (is_sentence_end(cp))
+        if (cls & kCpSentenceEnd)
         {
-            if (!prev_sentence_end)
-                sentences++;
-            prev_sentence_end = true;
+            if (!prev_sentence_end_)
+                sentences_++;
+            prev_sentence_end_ = true;
         }
         else
         {
-            prev_sentence_end = false;
+            prev_sentence_end_ = false;
         }
 
-        // caps stats
-        if (is_letter(cp))
+        // caps stats: caps_sequences нужен только факт upper-run >= 5
+        if (cls & kCpLetter)
         {
-            letters++;
-            if (is_upper(cp))
+            letters_++;
+            if (cls & kCpUpper)
             {
-                uppers++;
-                current_upper_run++;
-                max_upper_run = std::max(max_upper_run, current_upper_run);
+                uppers_++;
+                if (++upper_run_ == 5)
+                    caps_run_ = true;
             }
             else
             {
-                current_upper_run = 0;
+                upper_run_ = 0;
             }
         }
         else
         {
-            current_upper_run = 0;
+            upper_run_ = 0;
         }
 
-        // !!!, ??? runs (>=3)
+        // !!!, ??? и пробелы (>=3): серия засчитывается при достижении длины 3
         if (cp == '!')
-            exclam_run++;
-        else
         {
-            if (exclam_run >= 3)
-                m.exclam_runs++;
-            exclam_run = 0;
+            if (++exclam_run_ == 3)
+                m_.exclam_runs++;
         }
+        else
+            exclam_run_ = 0;
 
         if (cp == '?')
-            quest_run++;
-        else
         {
-            if (quest_run >= 3)
-                m.quest_runs++;
-            quest_run = 0;
+            if (++quest_run_ == 3)
+                m_.quest_runs++;
         }
+        else
+            quest_run_ = 0;
 
-        // long spaces
         if (cp == ' ')
-            space_run++;
-        else
         {
-            if (space_run >= 3)
-                m.long_space_runs++;
-            space_run = 0;
+            if (++space_run_ == 3)
+                m_.long_space_runs++;
         }
+        else
+            space_run_ = 0;
 
         // tokenize words
-        if (is_word_char(cp))
-        {
-            cur.push_back(to_lower_simple(cp));
-        }
-        else
+        if (cls & kCpWord)
+            push_word_cp(to_lower_simple(cp));
+        else if (word_len_ > 0)
+            end_word();
+    }
+
+    // ASCII-отрезок из len (1..32) первых байт блока, разобранного векторным ядром.
+    // Эквивалентно push() для каждого байта, но счётчики обновляются по маскам.
+    void push_ascii(const AsciiMasks &mk, unsigned len)
+    {
+        const uint32_t full = len == 32 ? ~0u : ((1u << len) - 1);
+        const unsigned last = len - 1;
+
+        m_.length_chars += len;
+        m_.junk_chars += popcount32(mk.junk & full);
+
+        const uint32_t se = mk.sent_end & full;
+        sentences_ += popcount32(se & ~((se << 1) | (prev_sentence_end_ ? 1u : 0u)));
+        prev_sentence_end_ = (se >> last) & 1u;
+
+        const uint32_t upper = mk.upper & full;
+        letters_ += popcount32(mk.letter & full);
+        uppers_ += popcount32(upper);
+        if (!caps_run_ && has_run<5>(upper, upper_run_))
+            caps_run_ = true;
+        upper_run_ = tail_run(upper, len, upper_run_);
+
+        const uint32_t ex = mk.exclam & full;
+        m_.exclam_runs += count_runs_reaching<3>(ex, exclam_run_);
+        exclam_run_ = tail_run(ex, len, exclam_run_);
+
+        const uint32_t qu = mk.quest & full;
+        m_.quest_runs += count_runs_reaching<3>(qu, quest_run_);
+        quest_run_ = tail_run(qu, len, quest_run_);
+
+        const uint32_t sp = mk.space & full;
+        m_.long_space_runs += count_runs_reaching<3>(sp, space_run_);
+        space_run_ = tail_run(sp, len, space_run_);
+
+        // слоги: начало группы гласных (гласные -- всегда символы слова)
+        const uint32_t v = Lang::kAsciiVowelsEn ? (mk.vowel_en & full) : 0u;
+        syllables_ += popcount32(v & ~((v << 1) | (prev_vowel_ ? 1u : 0u)));
+
+        // слова: отрезки единиц маски word
+        const uint32_t word = mk.word & full;
+        unsigned pos = 0;
+        while (pos < len)
         {
-            if (!cur.empty())
+            const uint32_t rest = word >> pos;
+            if (rest == 0)
+            {
+                if (word_len_ > 0)
+                    end_word();
+                break;
+            }
+            const unsigned skip = ctz32(rest);
+            if (skip > 0)
             {
-                words.push_back(cur);
-                cur.clear();
+                if (word_len_ > 0)
+                    end_word();
+                pos += skip;
             }
+            const uint32_t gaps = ~word >> pos; // биты за пределами len равны 1
+            const unsigned run = gaps ? ctz32(gaps) : 32 - pos;
+            push_word_bytes(mk.lower + pos, run);
+            pos += run;
         }
+        prev_vowel_ = (v >> last) & 1u;
+    }
 
-        prev_cp = cp;
+    // Следующий кусок того же текста, обработанный отдельным сканером (параллельный режим).
+    // Кусок должен начинаться с безопасной границы: перед ним пробельный ASCII-символ
+    // и не пробел в начале, т.е. все серии и слово текущего сканера уже закрыты.
+    // Повтор слова на стыке кусков определяет вызывающий (слова лежат в разных таблицах).
+    void absorb(const BasicMetricsScanner &next, bool dup_at_boundary)
+    {
+        m_.length_chars += next.m_.length_chars;
+        m_.junk_chars += next.m_.junk_chars;
+        m_.exclam_runs += next.m_.exclam_runs;
+        m_.quest_runs += next.m_.quest_runs;
+        m_.long_space_runs += next.m_.long_space_runs;
+
+        letters_ += next.letters_;
+        uppers_ += next.uppers_;
+        caps_run_ = caps_run_ || next.caps_run_;
+        sentences_ += next.sentences_;
+
+        word_count_ += next.word_count_;
+        total_word_len_ += next.total_word_len_;
+        syllables_ += next.syllables_;
+        dup_ += next.dup_ + (dup_at_boundary ? 1 : 0);
+
+        // состояние конца текста -- от последнего куска
+        upper_run_ = next.upper_run_;
+        prev_sentence_end_ = next.prev_sentence_end_;
+        exclam_run_ = next.exclam_run_;
+        quest_run_ = next.quest_run_;
+        space_run_ = next.space_run_;
+        word_hash_ = next.word_hash_;
+        word_len_ = next.word_len_;
+        prev_vowel_ = next.prev_vowel_;
+    }
+
+    // Первое и последнее завершённые слова, для стыков кусков. Байты -- пустые, если
+    // слов не было или слово не хранится (приближённый режим); хеши есть всегда.
+    int64_t word_count() const { return word_count_; }
+    std::string_view first_word() const
+    {
+        return first_word_ == WordTable::kNoWord ? std::string_view() : table_.word(first_word_hash_, first_word_);
+    }
+    std::string_view last_word() const
+    {
+        return prev_word_ == WordTable::kNoWord ? std::string_view() : table_.word(prev_word_hash_, prev_word_);
     }
+    uint64_t first_word_hash() const { return first_word_hash_; }
+    uint64_t last_word_hash() const { return prev_word_hash_; }
 
-    if (exclam_run >= 3)
-        m.exclam_runs++;
-    if (quest_run >= 3)
-        m.quest_runs++;
-    if (space_run >= 3)
-        m.long_space_runs++;
-    if (!cur.empty())
-        words.push_back(cur);
+    // nullptr -- уникальные слова считаются точно
+    const HyperLogLog *sketch() const { return sketch_.get(); }
 
-    m.word_count = static_cast<int64_t>(words.size());
-    m.sentences = std::max<int64_t>(1, sentences);
+    // Закрывает незавершённое слово в конце текста (или последнего куска).
+    void flush_word()
+    {
+        if (word_len_ > 0)
+            end_word();
+    }
 
-    // caps_sequences heuristic: если был длинный upper-run
-    m.caps_sequences = (max_upper_run >= 5) ? 1 : 0;
-    m.upper_ratio = (letters > 0) ? (double)uppers / (double)letters : 0.0;
+    TextMetrics finish(int64_t length_bytes)
+    {
+        flush_word();
+        if (sketch_)
+            return finish(length_bytes, unique_estimate(sketch_->estimate(), word_count_));
+        return finish(length_bytes, table_.unique_count());
+    }
 
-    // avg word len, unique pct, dup pct, syllables
-    if (m.word_count > 0)
+    // Оценка не может превышать число слов (на малых текстах HLL ошибается в обе стороны).
+    static size_t unique_estimate(double estimate, int64_t word_count)
     {
-        int64_t total_word_len = 0;
-        std::unordered_set<std::u32string, U32Hash> uniq;
-        uniq.reserve(words.size() * 2);
+        return static_cast<size_t>(std::min<double>(std::llround(estimate), double(word_count)));
+    }
 
-        int64_t dup = 0;
-        for (size_t k = 0; k < words.size(); ++k)
+    // unique_words -- число уникальных слов во всём тексте (в параллельном режиме
+    // считается по объединению таблиц кусков).
+    TextMetrics finish(int64_t length_bytes, size_t unique_words)
+    {
+        flush_word();
+
+        TextMetrics m = m_;
+        m.length_bytes = length_bytes;
+        m.word_count = word_count_;
+        m.sentences = std::max<int64_t>(1, sentences_);
+
+        // caps_sequences heuristic: если был длинный upper-run
+        m.caps_sequences = caps_run_ ? 1 : 0;
+        m.upper_ratio = (letters_ > 0) ? (double)uppers_ / (double)letters_ : 0.0;
+
+        if (m.word_count > 0)
         {
-            total_word_len += (int64_t)words[k].size();
-            uniq.insert(words[k]);
-            syllables += count_vowel_groups(words[k], lang);
-            if (k > 0 && words[k] == words[k - 1])
-                dup++;
-        }
+            m.avg_word_len = (double)total_word_len_ / (double)m.word_count;
+            m.unique_word_pct = 100.0 * (double)unique_words / (double)m.word_count;
+            if (m.word_count > 1)
+                m.consecutive_dup_pct = 100.0 * (double)dup_ / (double)(m.word_count - 1);
+            else
+                m.consecutive_dup_pct = 0.0;
 
-        m.avg_word_len = (double)total_word_len / (double)m.word_count;
-        m.unique_word_pct = 100.0 * (double)uniq.size() / (double)m.word_count;
-        if (m.word_count > 1)
-            m.consecutive_dup_pct = 100.0 * (double)dup / (double)(m.word_count - 1);
+            // readability (упрощённо)
+            const double target_wps = Lang::kTargetWordsPerSentence;
+            const double target_syl = Lang::kTargetSyllablesPerWord;
+            const double target_wlen = Lang::kTargetWordLen;
+
+            double wps = (double)m.word_count / (double)m.sentences;
+            double syl_per_word = (double)syllables_ / std::max<double>(1.0, (double)m.word_count);
+
+            double r = 100.0;
+            r -= std::max(0.0, (wps - target_wps)) * 2.0;
+            r -= std::max(0.0, (syl_per_word - target_syl)) * 25.0;
+            r -= std::max(0.0, (m.avg_word_len - target_wlen)) * 5.0;
+            r -= (m.upper_ratio > 0.35 ? 10.0 : 0.0);
+            r -= (m.exclam_runs + m.quest_runs) * 5.0;
+
+            m.readability = std::clamp(r, 0.0, 100.0);
+        }
         else
+        {
+            m.avg_word_len = 0.0;
+            m.unique_word_pct = 0.0;
             m.consecutive_dup_pct = 0.0;
+            m.readability = 0.0;
+        }
+        return m;
+    }
 
-        // readability (упрощённо)
-        double target_wps = (lang == "ru") ? 10.0 : 12.0;
-        double target_syl = (lang == "ru") ? 2.0 : 1.5;
-        double target_wlen = (lang == "ru") ? 6.0 : 5.0;
+private:
+    void push_word_byte(unsigned char b)
+    {
+        table_.push_byte(static_cast<char>(b));
+        word_hash_ = (word_hash_ ^ b) * 1099511628211ull;
+    }
 
-        double wps = (double)m.word_count / (double)m.sentences;
-        double syl_per_word = (double)syllables / std::max<double>(1.0, (double)m.word_count);
+    void push_word_bytes(const unsigned char *p, unsigned n)
+    {
+        table_.push_bytes(p, n);
+        uint64_t h = word_hash_;
+        for (unsigned k = 0; k < n; ++k)
+            h = (h ^ p[k]) * 1099511628211ull;
+        word_hash_ = h;
+        word_len_ += n;
+    }
 
-        double r = 100.0;
-        r -= std::max(0.0, (wps - target_wps)) * 2.0;
-        r -= std::max(0.0, (syl_per_word - target_syl)) * 25.0;
-        r -= std::max(0.0, (m.avg_word_len - target_wlen)) * 5.0;
-        r -= (m.upper_ratio > 0.35 ? 10.0 : 0.0);
-        r -= (m.exclam_runs + m.quest_runs) * 5.0;
+    void push_word_cp(uint32_t cpl)
+    {
+        // слово хранится в UTF-8: сравнение байтов == сравнение кодпоинтов
+        if (cpl < 0x80)
+        {
+            push_word_byte(static_cast<unsigned char>(cpl));
+        }
+        else
+        {
+            push_word_byte(static_cast<unsigned char>(0xC0 | (cpl >> 6)));
+            push_word_byte(static_cast<unsigned char>(0x80 | (cpl & 0x3F)));
+        }
+        word_len_++;
 
-        m.readability = std::clamp(r, 0.0, 100.0);
+        bool v = Lang::is_vowel(cpl);
+        if (v && !prev_vowel_)
+            syllables_++;
+        prev_vowel_ = v;
     }
-    else
+
+    void end_word()
+    {
+        uint32_t id = table_.intern(word_hash_);
+        if (id == WordTable::kNoWord)
+            return end_word_untracked();
+        if (id == prev_word_)
+            dup_++;
+        if (word_count_ == 0)
+        {
+            first_word_ = id;
+            first_word_hash_ = word_hash_;
+        }
+        prev_word_ = id;
+        next_word();
+    }
+
+    // Новое слово сверх лимита таблицы: дальше уникальные слова оцениваются скетчем.
+    // Повтор подряд двух таких слов определяется по совпадению 64-битного хеша.
+    void end_word_untracked()
+    {
+        if (!sketch_)
+            start_sketch();
+        sketch_->add(word_hash_);
+        if (prev_word_ == WordTable::kNoWord && word_count_ > 0 && word_hash_ == prev_word_hash_)
+            dup_++;
+        if (word_count_ == 0)
+            first_word_hash_ = word_hash_;
+        prev_word_ = WordTable::kNoWord;
+        next_word();
+    }
+
+    void next_word()
+    {
+        word_count_++;
+        total_word_len_ += word_len_;
+        prev_word_hash_ = word_hash_;
+
+        word_hash_ = kFnvOffset;
+        word_len_ = 0;
+        prev_vowel_ = false;
+    }
+
+    // Переход на HyperLogLog: уже собранные слова переносятся в скетч. Слова из таблицы
+    // и дальше находятся в ней (повторно в скетч их добавлять не нужно).
+    void start_sketch()
+    {
+        sketch_ = std::make_unique<HyperLogLog>(HyperLogLog::precision_for_error(sketch_error_));
+        table_.for_each_word([this](uint64_t h, const char *, size_t)
+                             { sketch_->add(h); });
+    }
+
+    static constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+
+    WordTable &table_;
+    const double sketch_error_;
+    std::unique_ptr<HyperLogLog> sketch_;
+    TextMetrics m_;
+
+    int64_t letters_ = 0;
+    int64_t uppers_ = 0;
+    int64_t upper_run_ = 0;
+    bool caps_run_ = false;
+
+    int64_t sentences_ = 0;
+    bool prev_sentence_end_ = false;
+
+    int64_t exclam_run_ = 0;
+    int64_t quest_run_ = 0;
+    int64_t space_run_ = 0;
+
+    // текущее слово
+    uint64_t word_hash_ = kFnvOffset;
+    int64_t word_len_ = 0;
+    bool prev_vowel_ = false;
+
+    int64_t word_count_ = 0;
+    int64_t total_word_len_ = 0;
+    int64_t syllables_ = 0;
+    int64_t dup_ = 0;
+    uint32_t prev_word_ = WordTable::kNoWord;
+    uint64_t prev_word_hash_ = 0;
+    uint32_t first_word_ = WordTable::kNoWord;
+    uint64_t first_word_hash_ = 0;
+};
+
+// Скалярный декодер: символы, начинающиеся в [i, stop). Не встраивается: внутри
+// scan_utf8 рядом с векторной веткой компилятор держит состояние сканера в памяти,
+// и отдельная копия цикла выходит заметно медленнее.
+template <class Scanner>
+__attribute__((noinline)) size_t scan_utf8_scalar(Scanner &scanner, const char *data, size_t size, size_t i, size_t stop)
+{
+    uint32_t cp = 0;
+    while (i < stop && utf8_next(data, size, i, cp))
+        scanner.push(cp);
+    return i;
+}
+
+// Проход по UTF-8 буферу: ASCII-отрезки идут через векторное ядро по 32 байта,
+// в скалярный декодер попадают не-ASCII байты и хвост короче блока. После плотного
+// не-ASCII блока (кириллица) kDenseSpan байт подряд декодируются скалярно без классификации.
+// Декодируются символы, начинающиеся до stop; читать можно до size (последовательность
+// может заходить за stop). Возвращает позицию после последнего символа.
+template <class Scanner>
+inline size_t scan_utf8(Scanner &scanner, const char *data, size_t size, SimdLevel level, size_t stop)
+{
+    constexpr unsigned kDenseNonAscii = 8; // из 32 байт блока
+    constexpr size_t kDenseSpan = 256;     // байт скалярного декодера после плотного блока
+    const Classify32Fn classify = classify32_for(level);
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+    size_t i = 0;
+    uint32_t cp = 0;
+
+    if (classify)
     {
-        m.avg_word_len = 0.0;
-        m.unique_word_pct = 0.0;
-        m.consecutive_dup_pct = 0.0;
-        m.readability = 0.0;
+        AsciiMasks mk;
+        while (i + 32 <= stop)
+        {
+            classify(p + i, mk);
+            if (popcount32(mk.nonascii) >= kDenseNonAscii)
+            {
+                // кириллица: ASCII-промежутки между словами слишком короткие для ядра,
+                // а классифицировать каждый блок заново дороже самого декодирования
+                i = scan_utf8_scalar(scanner, data, size, i, std::min(stop, i + kDenseSpan));
+                continue;
+            }
+
+            const unsigned ascii = mk.nonascii ? ctz32(mk.nonascii) : 32;
+            if (ascii > 0)
+            {
+                scanner.push_ascii(mk, ascii);
+                i += ascii;
+            }
+            if (ascii < 32)
+            {
+                do
+                {
+                    utf8_next(data, size, i, cp);
+                    scanner.push(cp);
+                } while (i < stop && p[i] >= 0x80);
+            }
+        }
     }
 
-    return m;
+    return scan_utf8_scalar(scanner, data, size, i, stop);
+}
+
+template <class Scanner>
+inline void scan_utf8(Scanner &scanner, const char *data, size_t size, SimdLevel level)
+{
+    scan_utf8(scanner, data, size, level, size);
+}
+
+inline TextMetrics compute_metrics(const char *data, size_t size, const std::string &lang,
+                                   const MetricsOptions &opts, SimdLevel level = active_simd_level())
+{
+    // таблица слов переиспользуется между вызовами в рамках потока
+    static thread_local WordTable table;
+    table.clear();
+
+    // язык выбирается один раз: дальше весь проход -- код, специализированный под него
+    return with_lang(lang, [&](auto l)
+                     {
+                         BasicMetricsScanner<decltype(l)> scanner(table, opts);
+                         scan_utf8(scanner, data, size, level);
+                         return scanner.finish(static_cast<int64_t>(size)); });
+}
+
+inline TextMetrics compute_metrics(const char *data, size_t size, const std::string &lang,
+                                   SimdLevel level = active_simd_level())
+{
+    return compute_metrics(data, size, lang, MetricsOptions{}, level);
+}
+
+inline TextMetrics compute_metrics(const std::string &text, const std::string &lang)
+{
+    return compute_metrics(text.data(), text.size(), lang);
 }
 
-inline int compute_score(const TextMetrics &m, const std::string &lang, std::vector<std::string> &errors)
+inline int compute_score(const TextMetrics &m, const std::string & /*lang*/, std::vector<std::string> &errors)
 {
     if (m.length_bytes == 0 || m.length_chars == 0)
     {
@@ -0,0 +1,187 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "text_quality.hpp"
+#include "thread_pool.hpp"
+
+// Параллельный compute_metrics для больших текстов: буфер режется на куски по
+// безопасным границам, куски сканируются независимо в пуле, а частичные
+// результаты сливаются так, что итог совпадает с последовательным до бита.
+//
+// Безопасная граница b (кусок начинается с байта b):
+//   - data[b-1] -- пробельный ASCII (' ', \t, \n, \r): слово, серии заглавных,
+//     !!!, ??? и конец предложения к этому месту уже закрыты;
+//   - data[b] != ' ': серия пробелов не продолжается в следующем куске;
+//   - data[b-4..b-2] -- ASCII: обрезанная кусок-границей многобайтовая
+//     последовательность декодируется так же, как в целом тексте.
+// Состояние, которое всё же пересекает границу, сливается явно: повтор слова
+// на стыке (сравнение байтов последнего и первого слов) и уникальные слова
+// (объединение таблиц, разбитое по хешу на независимые части).
+
+// Ближайшая безопасная граница в [from, size); size -- если её нет.
+inline size_t find_safe_boundary(const char *data, size_t size, size_t from)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+    for (size_t b = std::max<size_t>(from, 4); b < size; ++b)
+    {
+        const unsigned char ws = p[b - 1];
+        if (ws != ' ' && ws != '\t' && ws != '\n' && ws != '\r')
+            continue;
+        if (p[b] == ' ' || ((p[b - 2] | p[b - 3] | p[b - 4]) & 0x80))
+            continue;
+        return b;
+    }
+    return size;
+}
+
+struct ParallelMetricsOptions
+{
+    size_t min_chunk_bytes = size_t(256) << 10; // меньше -- накладные расходы больше выигрыша
+    size_t chunks_per_thread = 2;               // запас для выравнивания нагрузки
+    MetricsOptions metrics;
+};
+
+template <class Lang>
+inline TextMetrics compute_metrics_parallel(const char *data, size_t size, const std::vector<size_t> &bounds,
+                                            ThreadPool &pool, const MetricsOptions &opts, SimdLevel level)
+{
+    using Scanner = BasicMetricsScanner<Lang>;
+    const size_t workers = pool.size() + 1;
+    const size_t chunks = bounds.size() - 1;
+
+    // Таблицы и сканеры свои у каждого куска: thread_local таблицу compute_metrics
+    // использовать нельзя -- поток, ожидающий группу, может выполнять чужие задачи.
+    std::vector<std::unique_ptr<WordTable>> tables(chunks);
+    std::vector<std::unique_ptr<Scanner>> scanners(chunks);
+
+    // уникальные слова каждого куска, разложенные по частям хеша
+    struct WordRef
+    {
+        uint64_t hash;
+        const char *bytes;
+        size_t len;
+    };
+    size_t parts = 1;
+    unsigned part_bits = 0;
+    while (parts < workers)
+    {
+        parts <<= 1;
+        part_bits++;
+    }
+    auto part_of = [part_bits](uint64_t h)
+    {
+        // другие биты, чем у индекса WordTable (старшие биты h * 0x9E37...)
+        return part_bits ? static_cast<size_t>((h * 0xC2B2AE3D27D4EB4Full) >> (64 - part_bits)) : 0;
+    };
+    std::vector<std::vector<std::vector<WordRef>>> words(chunks, std::vector<std::vector<WordRef>>(parts));
+
+    parallel_for(pool, chunks, [&](size_t c)
+                 {
+                     tables[c] = std::make_unique<WordTable>();
+                     scanners[c] = std::make_unique<Scanner>(*tables[c], opts);
+                     scan_utf8(*scanners[c], data + bounds[c], bounds[c + 1] - bounds[c], level);
+                     scanners[c]->flush_word();
+                     tables[c]->for_each_word([&](uint64_t h, const char *bytes, size_t len)
+                                              { words[c][part_of(h)].push_back(WordRef{h, bytes, len}); }); });
+
+    bool approximate = false;
+    for (const auto &s : scanners)
+        approximate = approximate || s->sketch() != nullptr;
+
+    // объединение по частям: одно и то же слово всегда попадает в одну часть
+    size_t unique_words = 0;
+    if (!approximate)
+    {
+        std::vector<size_t> unique(parts, 0);
+        parallel_for(pool, parts, [&](size_t p)
+                     {
+                         WordTable merged;
+                         for (size_t c = 0; c < chunks; ++c)
+                         {
+                             for (const WordRef &w : words[c][p])
+                             {
+                                 merged.push_bytes(reinterpret_cast<const unsigned char *>(w.bytes), w.len);
+                                 merged.intern(w.hash);
+                             }
+                         }
+                         unique[p] = merged.unique_count(); });
+
+        for (size_t u : unique)
+            unique_words += u;
+        // последовательный проход перешёл бы на оценку по тому же порогу
+        approximate = opts.hll_threshold_words > 0 && unique_words > opts.hll_threshold_words;
+    }
+
+    // стыки: повтор слова сравнивается с последним словом предыдущих кусков
+    // (по байтам, если они хранятся, иначе по хешу -- как в приближённом режиме)
+    Scanner &total = *scanners[0];
+    bool have_last = total.word_count() > 0;
+    uint64_t last_hash = total.last_word_hash();
+    std::string_view last = total.last_word();
+    for (size_t c = 1; c < chunks; ++c)
+    {
+        const Scanner &next = *scanners[c];
+        bool dup = false;
+        if (next.word_count() > 0)
+        {
+            if (have_last && next.first_word_hash() == last_hash)
+            {
+                const std::string_view first = next.first_word();
+                dup = last.empty() || first.empty() || first == last;
+            }
+            have_last = true;
+            last_hash = next.last_word_hash();
+            last = next.last_word();
+        }
+        total.absorb(next, dup);
+    }
+
+    if (approximate)
+    {
+        // скетчи кусков + слова, оставшиеся в их таблицах
+        HyperLogLog sketch(HyperLogLog::precision_for_error(opts.hll_error));
+        for (size_t c = 0; c < chunks; ++c)
+        {
+            if (const HyperLogLog *s = scanners[c]->sketch())
+                sketch.merge(*s);
+            for (const auto &part : words[c])
+                for (const WordRef &w : part)
+                    sketch.add(w.hash);
+        }
+        unique_words = Scanner::unique_estimate(sketch.estimate(), total.word_count());
+    }
+    return total.finish(static_cast<int64_t>(size), unique_words);
+}
+
+inline TextMetrics compute_metrics_parallel(const char *data, size_t size, const std::string &lang,
+                                            ThreadPool &pool, ParallelMetricsOptions opts = {},
+                                            SimdLevel level = active_simd_level())
+{
+    const size_t workers = pool.size() + 1;
+    size_t want = std::max<size_t>(1, std::min(workers * opts.chunks_per_thread,
+                                               size / std::max<size_t>(1, opts.min_chunk_bytes)));
+    if (want == 1)
+        return compute_metrics(data, size, lang, opts.metrics, level);
+
+    // границы кусков: [bounds[c], bounds[c+1])
+    std::vector<size_t> bounds{0};
+    const size_t step = size / want;
+    for (size_t c = 1; c < want; ++c)
+    {
+        const size_t b = find_safe_boundary(data, size, std::max(c * step, bounds.back() + 1));
+        if (b >= size)
+            break;
+        bounds.push_back(b);
+    }
+    bounds.push_back(size);
+    if (bounds.size() == 2)
+        return compute_metrics(data, size, lang, opts.metrics, level);
+
+    return with_lang(lang, [&](auto l)
+                     { return compute_metrics_parallel<decltype(l)>(data, size, bounds, pool, opts.metrics, level); });
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(TEXT_QUALITY_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TEXT_QUALITY_X86 1
+#include <immintrin.h>
+#endif
+
+// Битовые маски классов для блока из 32 байт: бит k относится к байту k.
+// Классы (кроме nonascii) имеют смысл только для ASCII-байтов.
+struct AsciiMasks
+{
+    uint32_t nonascii = 0; // байт >= 0x80 -- дальше работает скалярный декодер
+    uint32_t letter = 0;   // A-Z a-z
+    uint32_t upper = 0;    // A-Z
+    uint32_t word = 0;     // буквы, цифры, '_' и '-'
+    uint32_t vowel_en = 0; // aeiouy в любом регистре
+    uint32_t space = 0;    // ' '
+    uint32_t exclam = 0;   // '!'
+    uint32_t quest = 0;    // '?'
+    uint32_t sent_end = 0; // . ! ?
+    uint32_t junk = 0;     // управляющие (кроме \t\n\r), 0x7F, ` ~ ^
+    alignas(32) unsigned char lower[32]; // байты блока, A-Z переведены в нижний регистр
+};
+
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+#ifdef TEXT_QUALITY_X86
+
+// Классификация 16 байт; результат -- 16-битные маски в младших битах.
+inline void classify16_sse2(const unsigned char *p, AsciiMasks &mk, unsigned shift)
+{
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    auto eq = [&](char c)
+    { return _mm_cmpeq_epi8(x, _mm_set1_epi8(c)); };
+    // знаковое сравнение: байты >= 0x80 отрицательны и в диапазоны не попадают
+    auto in = [&](char lo, char hi)
+    { return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                           _mm_cmplt_epi8(x, _mm_set1_epi8(static_cast<char>(hi + 1)))); };
+    auto bits = [](__m128i v)
+    { return static_cast<uint32_t>(_mm_movemask_epi8(v)); };
+
+    const __m128i upper = in('A', 'Z');
+    const __m128i letter = _mm_or_si128(upper, in('a', 'z'));
+    const __m128i word = _mm_or_si128(_mm_or_si128(letter, in('0', '9')), _mm_or_si128(eq('_'), eq('-')));
+    const __m128i low = _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    auto leq = [&](char c)
+    { return _mm_cmpeq_epi8(low, _mm_set1_epi8(c)); };
+    const __m128i vowel = _mm_and_si128(letter,
+                                        _mm_or_si128(_mm_or_si128(_mm_or_si128(leq('a'), leq('e')), _mm_or_si128(leq('i'), leq('o'))),
+                                                     _mm_or_si128(leq('u'), leq('y'))));
+    const __m128i exclam = eq('!');
+    const __m128i quest = eq('?');
+    const __m128i ctrl = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(eq('\t'), eq('\n')), eq('\r')),
+                                          in(0, 31));
+    const __m128i junk = _mm_or_si128(_mm_or_si128(ctrl, eq(0x7F)), _mm_or_si128(_mm_or_si128(eq('`'), eq('~')), eq('^')));
+
+    mk.nonascii |= bits(x) << shift;
+    mk.letter |= bits(letter) << shift;
+    mk.upper |= bits(upper) << shift;
+    mk.word |= bits(word) << shift;
+    mk.vowel_en |= bits(vowel) << shift;
+    mk.space |= bits(eq(' ')) << shift;
+    mk.exclam |= bits(exclam) << shift;
+    mk.quest |= bits(quest) << shift;
+    mk.sent_end |= bits(_mm_or_si128(_mm_or_si128(exclam, quest), eq('.'))) << shift;
+    mk.junk |= bits(junk) << shift;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(mk.lower + shift), low);
+}
+
+inline void classify32_sse2(const unsigned char *p, AsciiMasks &mk)
+{
+    mk = AsciiMasks{};
+    classify16_sse2(p, mk, 0);
+    classify16_sse2(p + 16, mk, 16);
+}
+
+// Лямбды не наследуют target("avx2"), поэтому вспомогательные функции отдельные.
+#define TQ_AVX2 __attribute__((target("avx2")))
+
+TQ_AVX2 inline __m256i avx2_eq(__m256i x, char c) { return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c)); }
+TQ_AVX2 inline __m256i avx2_in(__m256i x, char lo, char hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), x));
+}
+TQ_AVX2 inline uint32_t avx2_bits(__m256i v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+
+TQ_AVX2 inline void classify32_avx2(const unsigned char *p, AsciiMasks &mk)
+{
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+
+    const __m256i upper = avx2_in(x, 'A', 'Z');
+    const __m256i letter = _mm256_or_si256(upper, avx2_in(x, 'a', 'z'));
+    const __m256i word = _mm256_or_si256(_mm256_or_si256(letter, avx2_in(x, '0', '9')),
+                                         _mm256_or_si256(avx2_eq(x, '_'), avx2_eq(x, '-')));
+    const __m256i low = _mm256_or_si256(x, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+    const __m256i vowel = _mm256_and_si256(letter,
+                                           _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(avx2_eq(low, 'a'), avx2_eq(low, 'e')),
+                                                                           _mm256_or_si256(avx2_eq(low, 'i'), avx2_eq(low, 'o'))),
+                                                           _mm256_or_si256(avx2_eq(low, 'u'), avx2_eq(low, 'y'))));
+    const __m256i exclam = avx2_eq(x, '!');
+    const __m256i quest = avx2_eq(x, '?');
+    const __m256i ctrl = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(avx2_eq(x, '\t'), avx2_eq(x, '\n')), avx2_eq(x, '\r')),
+                                             avx2_in(x, 0, 31));
+    const __m256i junk = _mm256_or_si256(_mm256_or_si256(ctrl, avx2_eq(x, 0x7F)),
+                                         _mm256_or_si256(_mm256_or_si256(avx2_eq(x, '`'), avx2_eq(x, '~')), avx2_eq(x, '^')));
+
+    mk.nonascii = avx2_bits(x);
+    mk.letter = avx2_bits(letter);
+    mk.upper = avx2_bits(upper);
+    mk.word = avx2_bits(word);
+    mk.vowel_en = avx2_bits(vowel);
+    mk.space = avx2_bits(avx2_eq(x, ' '));
+    mk.exclam = avx2_bits(exclam);
+    mk.quest = avx2_bits(quest);
+    mk.sent_end = avx2_bits(_mm256_or_si256(_mm256_or_si256(exclam, quest), avx2_eq(x, '.')));
+    mk.junk = avx2_bits(junk);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mk.lower), low);
+}
+
+#undef TQ_AVX2
+
+#endif // TEXT_QUALITY_X86
+
+using Classify32Fn = void (*)(const unsigned char *, AsciiMasks &);
+
+inline SimdLevel detect_simd_level()
+{
+#ifdef TEXT_QUALITY_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::Avx2;
+    return SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// Уровень, выбранный по CPU один раз на процесс.
+inline SimdLevel active_simd_level()
+{
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+// nullptr -- векторного ядра нет, нужен скалярный декодер.
+inline Classify32Fn classify32_for(SimdLevel level)
+{
+#ifdef TEXT_QUALITY_X86
+    if (level == SimdLevel::Avx2)
+        return &classify32_avx2;
+    if (level == SimdLevel::Sse2)
+        return &classify32_sse2;
+#else
+    (void)level;
+#endif
+    return nullptr;
+}
+
+inline const char *simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Avx2:
+        return "avx2";
+    case SimdLevel::Sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <variant>
+
+#include "text_quality.hpp"
+
+// Потоковый compute_metrics: текст подаётся кусками произвольного размера через
+// feed(), итог -- finish(). Результат совпадает с compute_metrics по всему тексту
+// до бита при любой нарезке.
+//
+// Состояние между кусками -- сканер (серии, незавершённое слово) и не более
+// kCarryMax байт хвоста: последовательность UTF-8, которую ещё нельзя декодировать
+// так же, как в целом тексте (декодеру нужно знать, есть ли после неё ещё 3 байта).
+// Память растёт только с набором уникальных слов в WordTable (в приближённом режиме
+// MetricsOptions -- не больше порога hll_threshold_words).
+class TextMetricsAccumulator
+{
+public:
+    explicit TextMetricsAccumulator(const std::string &lang, SimdLevel level = active_simd_level())
+        : TextMetricsAccumulator(lang, MetricsOptions{}, level) {}
+
+    TextMetricsAccumulator(const std::string &lang, const MetricsOptions &opts,
+                           SimdLevel level = active_simd_level())
+        : level_(level), scanner_(make_scanner(lang, table_, opts)) {}
+
+    TextMetricsAccumulator(const TextMetricsAccumulator &) = delete;
+    TextMetricsAccumulator &operator=(const TextMetricsAccumulator &) = delete;
+
+    void feed(const char *data, size_t size)
+    {
+        std::visit([&](auto &scanner)
+                   { feed_impl(scanner, data, size); },
+                   scanner_);
+    }
+
+    void feed(const std::string &chunk) { feed(chunk.data(), chunk.size()); }
+
+    // Дочитывает хвост как конец текста. После finish() аккумулятор не используется.
+    TextMetrics finish()
+    {
+        return std::visit([&](auto &scanner)
+                          {
+                              scan_utf8(scanner, carry_, carry_len_, level_);
+                              carry_len_ = 0;
+                              return scanner.finish(static_cast<int64_t>(bytes_)); },
+                          scanner_);
+    }
+
+    uint64_t bytes_fed() const { return bytes_; }
+
+private:
+    // символ начинается не позже, чем за kLookahead байт до конца прочитанного --
+    // тогда декодер видит его целиком (максимум 4 байта) или честную ошибку
+    static constexpr size_t kLookahead = 3;
+    static constexpr size_t kCarryMax = kLookahead;
+
+    using Scanner = std::variant<BasicMetricsScanner<LangRu>, BasicMetricsScanner<LangEn>>;
+
+    static Scanner make_scanner(const std::string &lang, WordTable &table, const MetricsOptions &opts)
+    {
+        return with_lang(lang, [&](auto l)
+                         { return Scanner(std::in_place_type<BasicMetricsScanner<decltype(l)>>, table, opts); });
+    }
+
+    template <class S>
+    void feed_impl(S &scanner, const char *data, size_t size)
+    {
+        bytes_ += size;
+        size_t pos = 0;
+
+        if (carry_len_ > 0)
+        {
+            // хвост прошлого куска + начало нового: декодируем то, что начинается в хвосте
+            char tmp[kCarryMax + kLookahead + 1];
+            const size_t take = std::min(size, kLookahead + 1);
+            std::memcpy(tmp, carry_, carry_len_);
+            std::memcpy(tmp + carry_len_, data, take);
+            const size_t len = carry_len_ + take;
+            const size_t stop = std::min(carry_len_, len > kLookahead ? len - kLookahead : 0);
+            const size_t end = scan_utf8(scanner, tmp, len, level_, stop);
+            if (end < carry_len_)
+            {
+                // новый кусок слишком короткий: весь остаток снова в хвост (take == size)
+                carry_len_ = len - end;
+                std::memcpy(carry_, tmp + end, carry_len_);
+                return;
+            }
+            pos = end - carry_len_;
+            carry_len_ = 0;
+        }
+
+        if (size - pos > kLookahead)
+            pos += scan_utf8(scanner, data + pos, size - pos, level_, size - pos - kLookahead);
+
+        carry_len_ = size - pos;
+        std::memcpy(carry_, data + pos, carry_len_);
+    }
+
+    const SimdLevel level_;
+    WordTable table_;
+    Scanner scanner_;
+
+    char carry_[kCarryMax];
+    size_t carry_len_ = 0;
+    uint64_t bytes_ = 0;
+};
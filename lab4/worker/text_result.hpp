@@ -0,0 +1,25 @@
+#pragma once
+#include "text_quality.hpp"
+#include "wire.hpp"
+
+// TextMetrics -> поля метрик бинарного результата (wire.hpp).
+inline wire::MetricValues metrics_to_wire(const TextMetrics &m)
+{
+    using wire::metric_index;
+    wire::MetricValues v;
+    v.set_int(metric_index("length_chars"), m.length_chars);
+    v.set_int(metric_index("length_bytes"), m.length_bytes);
+    v.set_int(metric_index("word_count"), m.word_count);
+    v.set_double(metric_index("avg_word_len"), m.avg_word_len);
+    v.set_double(metric_index("unique_word_pct"), m.unique_word_pct);
+    v.set_double(metric_index("consecutive_dup_pct"), m.consecutive_dup_pct);
+    v.set_int(metric_index("sentences"), m.sentences);
+    v.set_int(metric_index("caps_sequences"), m.caps_sequences);
+    v.set_double(metric_index("upper_ratio"), m.upper_ratio);
+    v.set_int(metric_index("exclam_runs"), m.exclam_runs);
+    v.set_int(metric_index("quest_runs"), m.quest_runs);
+    v.set_int(metric_index("long_space_runs"), m.long_space_runs);
+    v.set_int(metric_index("junk_chars"), m.junk_chars);
+    v.set_double(metric_index("readability"), m.readability);
+    return v;
+}
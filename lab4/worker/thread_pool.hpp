@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Фиксированный пул потоков с общей очередью задач.
+// Поток, ожидающий TaskGroup, сам выполняет задачи из очереди,
+// поэтому вложенный parallel_for из задачи пула не приводит к deadlock.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads)
+    {
+        threads_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            threads_.emplace_back([this]
+                                  { worker_loop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t : threads_)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return threads_.size(); }
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            queue_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    friend class TaskGroup;
+
+    void worker_loop()
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        while (true)
+        {
+            cv_.wait(lk, [this]
+                     { return stop_ || !queue_.empty(); });
+            if (queue_.empty())
+                return; // stop_ и задач не осталось
+            auto task = std::move(queue_.front());
+            queue_.pop_front();
+            lk.unlock();
+            task();
+            lk.lock();
+        }
+    }
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> queue_;
+    std::vector<std::thread> threads_;
+    bool stop_ = false;
+};
+
+// Группа задач: run() ставит задачу в пул, wait() ждёт завершения всех,
+// помогая пулу выполнять очередь.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool &pool) : pool_(pool) {}
+    ~TaskGroup() { wait(); }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    template <class F>
+    void run(F &&f)
+    {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        ThreadPool *pool = &pool_;
+        pool_.submit([this, pool, fn = std::forward<F>(f)]() mutable
+                     {
+                         fn();
+                         if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                         {
+                             // после обнуления группа может быть уже разрушена: трогаем только пул
+                             std::lock_guard<std::mutex> lk(pool->mtx_);
+                             pool->cv_.notify_all();
+                         } });
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lk(pool_.mtx_);
+        while (pending_.load(std::memory_order_acquire) != 0)
+        {
+            if (!pool_.queue_.empty())
+            {
+                auto task = std::move(pool_.queue_.front());
+                pool_.queue_.pop_front();
+                lk.unlock();
+                task();
+                lk.lock();
+            }
+            else
+            {
+                pool_.cv_.wait(lk);
+            }
+        }
+    }
+
+private:
+    ThreadPool &pool_;
+    std::atomic<size_t> pending_{0};
+};
+
+// f(i) для i в [0, n): индексы раздаются динамически (задачи разного размера),
+// вызывающий поток участвует в работе.
+template <class F>
+void parallel_for(ThreadPool &pool, size_t n, F &&f)
+{
+    if (n == 0)
+        return;
+    std::atomic<size_t> next{0};
+    auto body = [&]
+    {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < n;
+             i = next.fetch_add(1, std::memory_order_relaxed))
+            f(i);
+    };
+
+    size_t helpers = std::min(pool.size(), n - 1);
+    TaskGroup group(pool);
+    for (size_t k = 0; k < helpers; ++k)
+        group.run(body);
+    body();
+    group.wait();
+}